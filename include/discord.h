@@ -102,15 +102,40 @@ extern "C" {
 
 typedef struct discord* discord_handle_t;
 
+typedef enum {
+    DISCORD_QUEUE_DROP_OLDEST,         /*<! Drop the oldest queued event to make space for the new one */
+    DISCORD_QUEUE_DROP_NEWEST,         /*<! Drop the new event */
+    DISCORD_QUEUE_COALESCE,            /*<! Replace queued update of the same message by the new one (MESSAGE_UPDATED), otherwise drop the oldest event */
+    DISCORD_QUEUE_SPILL                /*<! Put events into overflow ring (allocated in PSRAM if available). The oldest event is dropped only if the ring is full */
+} discord_queue_policy_t;
+
+typedef enum {
+    DISCORD_GW_DECODE_INLINE,          /*<! Decode payloads in websocket task. Socket is not read while payload is decoded (default) */
+    DISCORD_GW_DECODE_TASK,            /*<! Decode payloads in separate task, so receiving and decoding overlap */
+    DISCORD_GW_DECODE_TASK_CORE_0,     /*<! Same as DISCORD_GW_DECODE_TASK, but the task is pinned to core 0 */
+    DISCORD_GW_DECODE_TASK_CORE_1      /*<! Same as DISCORD_GW_DECODE_TASK, but the task is pinned to core 1 (ignored on single-core chips) */
+} discord_gateway_decode_t;
+
 typedef struct {
     char* token;
     int intents;
-    size_t gateway_buffer_size;
-    size_t api_buffer_size;
+    size_t gateway_buffer_size;        /*<! Maximum length of a single JSON token (string, number or key) in gateway payload. Payloads are parsed incrementally so they can be bigger than this */
+    bool gateway_compression;          /*<! Enable zlib-stream transport compression. Requires ~43 KB of additional heap for the inflate context */
+    discord_gateway_decode_t gateway_decode;  /*<! Where are received payloads decompressed and parsed. Decode task requires additional task stack and ~4 KB for received chunks */
+    size_t api_buffer_size;            /*<! Size of the buffer for API responses. List responses (guild channels, roles) are decoded while received and are not limited by it */
     size_t api_timeout_ms;
     uint8_t queue_size;
+    discord_queue_policy_t queue_policy;  /*<! What to do with received event if the queue is full (event handlers are slow). Receiving is never blocked */
+    uint16_t queue_overflow_size;      /*<! Size of the overflow ring for DISCORD_QUEUE_SPILL policy. Default is 32 */
     size_t task_stack_size;
     uint8_t task_priority;
+    uint8_t event_workers;             /*<! Number of tasks which run handlers of channel events (messages, reactions, voice states). Events of the same channel are always handled by the same task, in order. If the queue of the worker is full, event is dropped without blocking discord task (see discord_get_dropped_events). 0 to run all handlers in discord task (default). Maximum is 8 */
+    uint16_t shard_id;                 /*<! Shard handled by this client. Every shard is separate client (connection) with the same token */
+    uint16_t shard_count;              /*<! Total number of shards. 0 to not use sharding */
+    uint8_t max_concurrency;           /*<! Number of shards which can identify at the same time. Default is max_concurrency from GET /gateway/bot */
+    uint32_t reconnect_base_ms;        /*<! Base delay of reconnection. Delay of n-th attempt is random between 0 and min(reconnect_max_ms, reconnect_base_ms * 2^n). Default is 1 sec */
+    uint32_t reconnect_max_ms;         /*<! Maximum delay between two reconnection attempts. Default is 60 sec */
+    uint8_t reconnect_max_attempts;    /*<! Number of failed reconnection attempts after which client gives up and disconnects. 0 for unlimited */
 } discord_config_t;
 
 typedef enum {
@@ -158,12 +183,25 @@ typedef enum {
     DISCORD_EVENT_MESSAGE_REACTION_ADDED,      /*<! Reaction added to message */
     DISCORD_EVENT_MESSAGE_REACTION_REMOVED,    /*<! Reaction removed from message */
     DISCORD_EVENT_VOICE_STATE_UPDATED,         /*<! Voice state updated */
+    DISCORD_EVENT_RESUMED,                     /*<! Bot is reconnected and previous session is resumed. Events missed during disconnection are already replayed */
+    DISCORD_EVENT_GATEWAY_LATENCY,             /*<! Heartbeat is acknowledged by gateway (once per heartbeat interval). Data is discord_gateway_latency_t* with updated statistics */
+    _DISCORD_EVENT_MAX
 } discord_event_t;
 
+typedef struct {
+    uint32_t last_ms;                  /*<! Round-trip time of the last heartbeat */
+    uint32_t min_ms;                   /*<! Minimal round-trip time of the latest heartbeats */
+    uint32_t avg_ms;                   /*<! Average round-trip time of the latest heartbeats */
+    uint32_t p99_ms;                   /*<! 99th percentile of the round-trip times of the latest heartbeats */
+    uint8_t samples;                   /*<! Number of the latest heartbeats from which are statistics calculated. Zero if no heartbeat is acknowledged yet */
+    uint32_t missed;                   /*<! Number of heartbeats which were not acknowledged (each of them caused reconnection) */
+} discord_gateway_latency_t;
+
 typedef void* discord_event_data_ptr_t;
 
 typedef struct {
     discord_handle_t client;
+    uint16_t shard_id;                 /*!< Shard which received the event (config.shard_id of the client) */
     discord_event_data_ptr_t ptr;
 } discord_event_data_t;
 
@@ -181,16 +219,35 @@ discord_handle_t discord_create(const discord_config_t* config);
  * @brief Cannot be called from event handler
  */
 esp_err_t discord_login(discord_handle_t client);
+/**
+ * @brief Register event handler. Data of the gateway events without any registered handler is not deserialized at all.
+ *        If event workers are enabled, handlers of channel events (including DISCORD_EVENT_ANY handlers) run on the workers,
+ *        so the same handler can be invoked by multiple tasks at the same time
+ */
 esp_err_t discord_register_events(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler, void* event_handler_arg);
+/**
+ * @brief Unregister event handler. Function returns once the handler is not invoked by any task, so its argument can be freed then.
+ *        If called from event handler, it does not wait for other tasks (it could deadlock otherwise)
+ */
 esp_err_t discord_unregister_events(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler);
 esp_err_t discord_get_state(discord_handle_t client, discord_gateway_state_t* out_state);
 esp_err_t discord_get_close_code(discord_handle_t client, discord_close_code_t* out_code);
 /**
- * @brief Cannot be called from event handler
+ * @brief Get round-trip time statistics of the gateway heartbeats. ACK is timestamped when it's received,
+ *        so the statistics show the network latency and they are not affected by slow event handlers
+ */
+esp_err_t discord_get_gateway_latency(discord_handle_t client, discord_gateway_latency_t* out_latency);
+/**
+ * @brief Get number of events which were dropped because the queue was full (see queue_policy)
+ * @param event Event type, or DISCORD_EVENT_ANY for total number of dropped events
+ */
+esp_err_t discord_get_dropped_events(discord_handle_t client, discord_event_t event, uint32_t* out_count);
+/**
+ * @brief Cannot be called from event handler or from callback of asynchronous request
  */
 esp_err_t discord_logout(discord_handle_t client);
 /**
- * @brief Cannot be called from event handler
+ * @brief Cannot be called from event handler or from callback of asynchronous request
  */
 esp_err_t discord_destroy(discord_handle_t client);
 
@@ -6,9 +6,10 @@ extern "C" {
 #endif
 
 #include "discord.h"
+#include "discord/snowflake.h"
 
 typedef struct {
-    char* id;
+    discord_snowflake_t id;                /*<! For the attachments which are going to be sent, it's index of the attachment in message */
     char* filename;
     char* content_type;
     size_t size;
@@ -18,7 +19,7 @@ typedef struct {
 } discord_attachment_t;
 
 #define discord_attachment_dump_log(LOG_FOO, TAG, attachment) \
-    LOG_FOO(TAG, "attachment (id=%s, filename=%s, type=%s, size=%d, url=%s)", \
+    LOG_FOO(TAG, "attachment (id=%" DISCORD_SNOWFLAKE_FMT ", filename=%s, type=%s, size=%d, url=%s)", \
         attachment->id, \
         attachment->filename, \
         attachment->content_type ? attachment->content_type : "NULL", \
@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include "discord.h"
+#include "discord/snowflake.h"
 
 typedef enum {
     DISCORD_CHANNEL_GUILD_TEXT,      /*<! a text channel within a server */
@@ -22,11 +23,17 @@ typedef enum {
 } discord_channel_type_t;
 
 typedef struct {
-    char* id;
+    discord_snowflake_t id;
     discord_channel_type_t type;
     char* name;
 } discord_channel_t;
 
+/**
+ * @brief Function which receives channels one by one. Channel is freed after function returns
+ * @return true to continue, false to stop the iteration
+ */
+typedef bool(*discord_channel_visitor_t)(discord_channel_t* channel, void* arg);
+
 discord_channel_t* discord_channel_get_from_array_by_name(discord_channel_t** array, int array_len, const char* channel_name);
 void discord_channel_free(discord_channel_t* channel);
 
@@ -7,9 +7,10 @@ extern "C" {
 
 #include "discord.h"
 #include "discord/channel.h"
+#include "discord/snowflake.h"
 
 typedef struct {
-    char* id;
+    discord_snowflake_t id;
     char* name;
     char* permissions;
 } discord_guild_t;
@@ -23,6 +24,15 @@ typedef struct {
  * @return ESP_OK on success
  */
 esp_err_t discord_guild_get_channels(discord_handle_t client, discord_guild_t* guild, discord_channel_t*** out_channels, int* out_length);
+/**
+ * @brief Iterate over guild channels while they are received. Only one channel is in memory at a time
+ * @param client Discord client handle
+ * @param guild Guild
+ * @param visitor Function which receives channels. Return false from it to stop the iteration
+ * @param arg User argument passed to the visitor
+ * @return ESP_OK on success (also if iteration is stopped by the visitor)
+ */
+esp_err_t discord_guild_foreach_channel(discord_handle_t client, discord_guild_t* guild, discord_channel_visitor_t visitor, void* arg);
 void discord_guild_free(discord_guild_t* guild);
 
 #ifdef __cplusplus
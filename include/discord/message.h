@@ -41,12 +41,12 @@ typedef enum {
 } discord_message_type_t;
 
 typedef struct {
-    char* id;
+    discord_snowflake_t id;
     discord_message_type_t type;
     char* content;
-    char* channel_id;
+    discord_snowflake_t channel_id;
     discord_user_t* author;
-    char* guild_id;
+    discord_snowflake_t guild_id;      /*<! DISCORD_SNOWFLAKE_NULL for direct messages */
     discord_member_t* member;
     discord_attachment_t** attachments;
     uint8_t _attachments_len;
@@ -73,7 +73,7 @@ typedef struct {
 } discord_message_word_t;
 
 #define discord_message_dump_log(LOG_FOO, TAG, msg) \
-    LOG_FOO(TAG, "New message (content=%s, autor=%s#%s, bot=%s, attachments_len=%d, channel=%s, dm=%s, guild=%s)", \
+    LOG_FOO(TAG, "New message (content=%s, autor=%s#%s, bot=%s, attachments_len=%d, channel=%" DISCORD_SNOWFLAKE_FMT ", dm=%s, guild=%" DISCORD_SNOWFLAKE_FMT ")", \
         msg->content, \
         msg->author->username, \
         msg->author->discriminator, \
@@ -81,11 +81,31 @@ typedef struct {
         msg->_attachments_len, \
         msg->channel_id, \
         msg->guild_id ? "false" : "true", \
-        msg->guild_id ? msg->guild_id : "NULL" \
+        msg->guild_id \
     );
 
+/**
+ * @brief Callback of asynchronous message request. It is called from the api worker task
+ * @param err Result of the request
+ * @param message Sent message (only for discord_message_send_async, otherwise NULL). Message is freed after callback returns
+ */
+typedef void (*discord_message_callback_t)(discord_handle_t client, esp_err_t err, discord_message_t* message, void* arg);
+
 esp_err_t discord_message_send(discord_handle_t client, discord_message_t* message, discord_message_t** out_result);
 esp_err_t discord_message_react(discord_handle_t client, discord_message_t* message, const char* emoji);
+/**
+ * @brief Queue the message for sending and return immediately. Message is serialized before return and can be freed,
+ *        but data of attachments which is not owned by attachment (_data_should_be_freed) must stay valid until callback is called
+ * @param callback Function called when message is sent (or fail to send). Can be NULL
+ * @return ESP_OK if message is queued
+ */
+esp_err_t discord_message_send_async(discord_handle_t client, discord_message_t* message, discord_message_callback_t callback, void* arg);
+/**
+ * @brief Queue the reaction and return immediately. Message and emoji can be freed after return
+ * @param callback Function called when reaction is added (or fail to add). Can be NULL
+ * @return ESP_OK if reaction is queued
+ */
+esp_err_t discord_message_react_async(discord_handle_t client, discord_message_t* message, const char* emoji, discord_message_callback_t callback, void* arg);
 esp_err_t discord_message_download_attachment(discord_handle_t client, discord_message_t* message, uint8_t attachment_index, discord_download_handler_t download_handler, void* arg);
 esp_err_t discord_message_word_parse(const char* word, discord_message_word_t** out_word);
 esp_err_t discord_message_add_attachment(discord_message_t* message, discord_attachment_t* attachment);
@@ -2,15 +2,16 @@
 #define _DISCORD_MESSAGE_REACTION_H_
 
 #include "discord/emoji.h"
+#include "discord/snowflake.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef struct {
-    char* user_id;
-    char* message_id;
-    char* channel_id;
+    discord_snowflake_t user_id;
+    discord_snowflake_t message_id;
+    discord_snowflake_t channel_id;
     discord_emoji_t* emoji;
 } discord_message_reaction_t;
 
@@ -0,0 +1,52 @@
+#ifndef _DISCORD_PRESENCE_H_
+#define _DISCORD_PRESENCE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "discord.h"
+
+typedef enum {
+    DISCORD_ACTIVITY_PLAYING,        /*!< Playing {name} */
+    DISCORD_ACTIVITY_STREAMING,      /*!< Streaming {name} */
+    DISCORD_ACTIVITY_LISTENING,      /*!< Listening to {name} */
+    DISCORD_ACTIVITY_WATCHING,       /*!< Watching {name} */
+    DISCORD_ACTIVITY_CUSTOM,         /*!< {state} (custom status) */
+    DISCORD_ACTIVITY_COMPETING       /*!< Competing in {name} */
+} discord_activity_type_t;
+
+typedef struct {
+    char* name;                      /*!< Activity name. If NULL, "Custom Status" is used */
+    discord_activity_type_t type;
+    char* state;                     /*!< User's current party status, or text used for custom status. Can be NULL */
+} discord_activity_t;
+
+typedef enum {
+    DISCORD_PRESENCE_ONLINE,
+    DISCORD_PRESENCE_DND,            /*!< Do not disturb */
+    DISCORD_PRESENCE_IDLE,
+    DISCORD_PRESENCE_INVISIBLE
+} discord_presence_status_t;
+
+typedef struct {
+    discord_presence_status_t status;
+    discord_activity_t* activity;    /*!< Bot activity. NULL to clear it */
+    bool afk;
+} discord_presence_t;
+
+/**
+ * @brief Update presence (status and activity) of the bot. Updates are coalesced: at most one is sent
+ *        per DISCORD_PRESENCE_INTERVAL_MS (the latest one wins) and update which does not change presence is not sent at all.
+ *        Presence set before connection (or reconnection) is sent once the bot is identified
+ * @param client Discord client handle
+ * @param presence Presence to set. It's serialized immediately, so it can be freed after the call
+ * @return ESP_OK on success (update is sent or scheduled)
+ */
+esp_err_t discord_presence_update(discord_handle_t client, const discord_presence_t* presence);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
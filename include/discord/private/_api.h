@@ -7,6 +7,8 @@ extern "C" {
 
 #include "esp_http_client.h"
 #include "discord.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_json.h"
 
 #define DCAPI_REQUEST_BOUNDARY "esp-discord"
 
@@ -31,8 +33,16 @@ typedef struct {
     bool data_should_be_freed; /*<! Set to true if data should be freed by discord_api_multipart_free function */
 } discord_api_multipart_t;
 
+/**
+ * @brief Handler of response body chunks
+ * @return ESP_OK to continue, otherwise rest of the body is ignored and request fails with returned error
+ */
+typedef esp_err_t (*dcapi_stream_handler_t)(const char* data, size_t len, void* arg);
+
 typedef struct {
     char* uri;
+    dcapi_stream_handler_t stream_handler;  /*<! Optional. Body of successful response is passed to the handler instead of recording it into api buffer */
+    void* stream_arg;
     discord_api_multipart_t** multiparts;
     uint8_t multiparts_len;
     bool disable_auto_uri_free;
@@ -45,10 +55,44 @@ typedef struct {
     int data_len;
 } discord_api_response_t;
 
+/**
+ * @brief Callback of asynchronous request. Response is released after callback returns
+ * @param err Result of the request (see dcapi_request)
+ * @param res Response or NULL if request has not been sent
+ */
+typedef void (*dcapi_callback_t)(discord_handle_t client, esp_err_t err, discord_api_response_t* res, void* arg);
+
+/**
+ * @brief Calculate route identifier of the request. Routes with the same method and path share the rate limit bucket,
+ *        except that the top-level (major) parameters (channel, guild, webhook) split buckets. All of reaction routes of the message share one bucket
+ */
+uint32_t dcapi_route_hash(esp_http_client_method_t method, const char* uri);
+/**
+ * @brief Find rate limit bucket of the route
+ * @param create Replace the least recently used bucket if the route has none
+ * @return Bucket or NULL if route has no bucket (and create is false)
+ */
+discord_api_bucket_t* dcapi_bucket_get(discord_handle_t client, uint32_t route, bool create);
 bool dcapi_response_is_success(discord_api_response_t* res);
 esp_err_t dcapi_response_to_esp_err(discord_api_response_t* res);
 esp_err_t dcapi_response_free(discord_handle_t client, discord_api_response_t* res);
 esp_err_t dcapi_request(discord_handle_t client, esp_http_client_method_t method, discord_api_request_t* request, discord_api_response_t** out_response);
+/**
+ * @brief Put request to the queue from which requests are sent by api worker task. Worker is started on the first request
+ * @param request Request which will be freed after it is sent (or in case of error)
+ * @param callback Function which is called from api worker task when request is done. Can be NULL
+ * @return ESP_OK if request is queued, ESP_ERR_INVALID_STATE if client is not connected, ESP_FAIL if the queue is full
+ */
+esp_err_t dcapi_request_async(discord_handle_t client, esp_http_client_method_t method, discord_api_request_t* request, dcapi_callback_t callback, void* arg);
+/**
+ * @brief Check whether the current task is api worker (caller is the callback of asynchronous request)
+ */
+bool dcapi_is_worker(discord_handle_t client);
+/**
+ * @brief Stop api worker task. Callbacks of pending requests are called with ESP_ERR_INVALID_STATE.
+ *        Cannot be called from api worker
+ */
+void dcapi_worker_stop(discord_handle_t client);
 esp_err_t dcapi_download(discord_handle_t client, const char* url, discord_download_handler_t download_handler, discord_api_response_t** out_response, void* arg);
 esp_err_t dcapi_add_multipart_to_request(discord_api_multipart_t* multipart, discord_api_request_t* request);
 void discord_api_request_free(discord_api_request_t* request);
@@ -63,6 +107,32 @@ discord_api_request_t* dcapi_create_request(char* uri, char* payload);
  * @note data will be automatically freed
  */ 
 esp_err_t dcapi_get(discord_handle_t client, char* uri, char* data, discord_api_response_t** out_response);
+/**
+ * @brief GET request with own short-living connection. It does not use api lock and persistent client,
+ *        so it can be sent while gateway is not connected (ex: GET /gateway/bot before the connection)
+ * 
+ * @param out_data Null-terminated body of successful response. Needs to be freed
+ * @return ESP_ERR_INVALID_RESPONSE if response is not successful, ESP_ERR_INVALID_SIZE if body is bigger than api buffer size
+ */
+esp_err_t dcapi_get_oneshot(discord_handle_t client, const char* uri, char** out_data, int* out_len);
+/**
+ * @brief GET request of the JSON array. Response is decoded while it is received, so it's not limited by api buffer size
+ * 
+ * @param uri URI which will be automatically freed
+ * @param schema Schema of the array items
+ * @param out_list Decoded items, allocated on heap
+ * @return ESP_ERR_INVALID_RESPONSE if response is not successful
+ */
+esp_err_t dcapi_get_list(discord_handle_t client, char* uri, const dcjs_schema_t* schema, void*** out_list, int* out_len);
+/**
+ * @brief GET request of the JSON array. Items are passed to the visitor one by one while response is received
+ * 
+ * @param uri URI which will be automatically freed
+ * @param schema Schema of the array items
+ * @param visitor Function which receives items. Item is freed after visitor returns. Return false from visitor to stop
+ * @return ESP_ERR_INVALID_RESPONSE if response is not successful
+ */
+esp_err_t dcapi_foreach(discord_handle_t client, char* uri, const dcjs_schema_t* schema, discord_list_visitor_t visitor, void* arg);
 /**
  * @brief POST request
  * 
@@ -76,6 +146,9 @@ esp_err_t dcapi_post(discord_handle_t client, char* uri, char* data, discord_api
  */
 esp_err_t dcapi_put(discord_handle_t client, char* uri, char* data, discord_api_response_t** out_response);
 
+/**
+ * @brief Release api buffer and persistent clients (on disconnection). Api lock is kept until the client is destroyed
+ */
 esp_err_t dcapi_destroy(discord_handle_t client);
 
 #ifdef __cplusplus
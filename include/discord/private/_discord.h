@@ -14,6 +14,7 @@ extern "C" {
 #include "esp_event_base.h"
 #include "esp_websocket_client.h"
 #include "esp_http_client.h"
+#include "esp_timer.h"
 #include "_models.h"
 #include "discord.h"
 #include "discord_ota.h"
@@ -24,7 +25,10 @@ extern "C" {
 #define CONFIG_IDF_TARGET "esp32"
 #endif
 
-#define DISCORD_GW_URL                   "wss://gateway.discord.gg/?v=10&encoding=json"
+#define DISCORD_GW_HOST                  "wss://gateway.discord.gg"
+#define DISCORD_GW_QUERY                 "/?v=10&encoding=json"
+#define DISCORD_GW_URL                   DISCORD_GW_HOST DISCORD_GW_QUERY
+#define DISCORD_GW_QUERY_COMPRESS        "&compress=zlib-stream"
 #define DISCORD_API_URL                  "https://discord.com/api/v10"
 
 // this should go into menuconfig configuration
@@ -34,11 +38,57 @@ extern "C" {
 #define DISCORD_DEFAULT_API_BUFFER_SIZE  (3 * 1024)
 #define DISCORD_DEFAULT_API_TIMEOUT_MS   (8000)
 #define DISCORD_DEFAULT_QUEUE_SIZE       (3)
+#define DISCORD_CONTROL_QUEUE_SIZE       (4)
+#define DISCORD_DEFAULT_QUEUE_OVERFLOW_SIZE (32)
+#define DISCORD_DEFAULT_API_QUEUE_SIZE   (4)
+#define DISCORD_DEFAULT_MAX_CONCURRENCY  (1)
+#define DISCORD_DEFAULT_RECONNECT_BASE_MS (1000)
+#define DISCORD_DEFAULT_RECONNECT_MAX_MS (60000)
+
+#define DISCORD_API_BUCKETS              (8)      /*<! Number of tracked rate limit buckets. Least recently used bucket is replaced */
+#define DISCORD_API_GLOBAL_LIMIT         (50)     /*<! Maximum number of requests per second (global rate limit) */
+
+#define DISCORD_STOPPED_BIT              (1 << 0)
+#define DISCORD_API_STOPPED_BIT          (1 << 1)
+#define DISCORD_GW_DECODE_STOPPED_BIT    (1 << 2)
+#define DISCORD_WORKER_STOPPED_BIT(i)    (1 << (8 + (i)))
+
+#define DISCORD_EVENT_HANDLERS_INITIAL   (4)      /*<! Initial capacity of handlers of one event. Capacity is doubled when it's full */
+#define DISCORD_EVENT_WORKERS_MAX        (8)
+#define DISCORD_EVENT_WORKER_QUEUE_SIZE  (16)     /*<! Events submitted to the busy worker are dropped once its queue is full */
+
+#define DISCORD_GW_WS_BUFFER_SIZE        (512)    /*<! Size of the websocket client buffer, the maximum length of received chunk */
+#define DISCORD_GW_DECODE_CHUNKS         (8)      /*<! Number of received chunks which can wait for decoding */
+#define DISCORD_GW_DECODE_TIMEOUT_MS     (1000)   /*<! How long websocket task waits for a free chunk before the connection is considered broken */
+
+#define DISCORD_NOTIFY_PAYLOAD           (1 << 0)  /*<! Payload is put into the queue */
+#define DISCORD_NOTIFY_HEARTBEAT         (1 << 1)  /*<! Heartbeat interval is elapsed */
+#define DISCORD_NOTIFY_STATE             (1 << 2)  /*<! Gateway state (or running flag) is changed */
+#define DISCORD_NOTIFY_OUTBOX            (1 << 3)  /*<! Gateway rate limit is refilled and pending payloads can be sent */
+#define DISCORD_NOTIFY_PRESENCE          (1 << 4)  /*<! Presence update window is elapsed and pending presence can be sent */
+#define DISCORD_NOTIFY_IDENTIFY          (1 << 5)  /*<! Delayed identify can be sent */
+
+#define DISCORD_GW_IDENTIFY_INTERVAL_MS  5000      /*<! Shards with the same rate limit key (shard_id % max_concurrency) can identify once per interval */
+#define DISCORD_GW_IDENTIFY_KEYS         16        /*<! Number of tracked rate limit keys. Bigger max_concurrency is limited to it */
+#define DISCORD_GW_INVALID_SESSION_MIN_MS 1000     /*<! Identify after non-resumable INVALID_SESSION is delayed by random time from this range */
+#define DISCORD_GW_INVALID_SESSION_MAX_MS 5000
+#define DISCORD_GW_INFO_URL_SIZE         64
+#define DISCORD_GW_INFO_TTL_SEC          (6 * 60 * 60)  /*<! How long is GET /gateway/bot response cached in NVS */
+
+#define DISCORD_PRESENCE_INTERVAL_MS     5000      /*<! Minimal interval between two presence updates */
+
+// Gateway allows 120 commands per 60 sec. Bucket with 60 tokens refilled by one token every second
+// never exceeds it in any 60 sec window (60 burst + 60 refilled)
+#define DISCORD_GW_RATELIMIT_TOKENS      60
+#define DISCORD_GW_RATELIMIT_REFILL_MS   1000
+#define DISCORD_GW_RATELIMIT_RESERVED    4         /*<! Tokens which can be used only by control payloads (heartbeat, identify, resume) */
+#define DISCORD_GW_OUTBOX_SIZE           16        /*<! Maximum number of pending payloads. Control payloads are queued even if the outbox is full */
 
 #define DISCORD_LOG_TAG "DISCORD"
 
 #define DISCORD_NVS_NAMESPACE "discord_nvs"
 #define DISCORD_NVS_KEY_TOKEN "token"
+#define DISCORD_NVS_KEY_GATEWAY_BOT "gateway_bot"
 
 #define DISCORD_LOG_DEFINE_BASE() static const char* TAG = DISCORD_LOG_TAG
 #define DISCORD_LOG(esp_log_foo, format, ...) esp_log_foo(TAG, "%s: " format, __func__, ##__VA_ARGS__)
@@ -50,17 +100,29 @@ extern "C" {
 #define DISCORD_LOG_FOO() DISCORD_LOGD("...")
 
 #define DISCORD_EVENT_FIRE(event, data) client->event_handler(client, event, data)
+#define DISCORD_NOTIFY(bits) \
+    do { TaskHandle_t _task = client->task_handle; if(_task) { xTaskNotify(_task, (bits), eSetBits); } } while(0)
+#define DISCORD_EVENT_HAS_SUBSCRIBERS(event) \
+    (client->any_handlers.len > 0 || ((event) >= 0 && (event) < _DISCORD_EVENT_MAX && client->handlers[(event)].len > 0))
 
 #define STRDUP(str) (str ? strdup(str) : NULL)
 
 typedef enum {
     DISCORD_CLOSE_REASON_NOT_REQUESTED,
     DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED,
+    DISCORD_CLOSE_REASON_RECONNECT,            /*<! Gateway requested reconnection (and resume) */
     DISCORD_CLOSE_REASON_LOGOUT,
     DISCORD_CLOSE_REASON_DESTROY,
     DISCORD_CLOSE_REASON_ERROR
 } discord_gateway_close_reason_t;
 
+typedef enum {
+    DISCORD_RECONNECT_RESUME,                  /*<! Reconnect and resume the session. First attempt is immediate */
+    DISCORD_RECONNECT_BACKOFF,                 /*<! Reconnect and resume the session, but always after backoff delay */
+    DISCORD_RECONNECT_NEW_SESSION,             /*<! Session cannot be resumed, reconnect and identify */
+    DISCORD_RECONNECT_NEVER                    /*<! Reconnection would fail again (invalid token, intents, shard...) */
+} discord_reconnect_rule_t;
+
 enum {
     DISCORD_OP_DISPATCH,                    /*!< [Receive] An event was dispatched */
     DISCORD_OP_HEARTBEAT,                   /*!< [Send/Receive] An event was dispatched */
@@ -78,13 +140,164 @@ enum {
 #define _DISCORD_CLOSEOP_MIN DISCORD_CLOSEOP_UNKNOWN_ERROR
 #define _DISCORD_CLOSEOP_MAX DISCORD_CLOSEOP_DISALLOWED_INTENTS
 
+typedef struct discord_gw_outbound {
+    int op;
+    char* data;                      /*<! Serialized payload */
+    struct discord_gw_outbound* next;
+} discord_gw_outbound_t;
+
+typedef struct {
+    discord_gw_outbound_t* head;     /*<! Pending payloads ordered by priority (FIFO within the same priority) */
+    uint8_t len;
+    int tokens;                      /*<! Number of payloads which can be sent right now */
+    uint64_t refill_ms;              /*<! Time when the bucket was refilled last time */
+    esp_timer_handle_t timer;        /*<! One-shot timer which notifies discord task when the next token is available */
+} discord_gw_outbox_t;
+
+typedef struct {
+    SemaphoreHandle_t lock;          /*<! Mutex, because presence is sent while it's held (presence is flushed by any task and discord task) */
+    char* pending;                   /*<! Serialized presence which waits to be sent. NULL if there is nothing to send */
+    char* sent;                      /*<! Serialized presence which is sent last time (used to skip unchanged updates) */
+    uint64_t sent_ms;
+    esp_timer_handle_t timer;        /*<! One-shot timer which notifies discord task when the update window is elapsed */
+} discord_gw_presence_t;
+
+/**
+ * @brief Connection info of the bot (GET /gateway/bot)
+ */
+typedef struct {
+    bool loaded;
+    char url[DISCORD_GW_INFO_URL_SIZE];    /*<! Gateway url (without query) */
+    uint16_t shards;                 /*<! Recommended number of shards */
+    uint8_t max_concurrency;
+    uint32_t remaining;              /*<! Remaining number of session starts (identifies) */
+    uint64_t reset_ms;               /*<! Time when the remaining number is reset. 0 if unknown */
+    int64_t reset_at;                /*<! Unix time when the remaining number is reset. 0 if unknown or wall clock was not set */
+    int64_t expires_at;              /*<! Unix time when the info needs to be fetched again. 0 if wall clock was not set */
+} discord_gw_info_t;
+
+/**
+ * @brief Fragment of the received websocket frame
+ */
+typedef struct {
+    uint8_t op_code;
+    bool first;                      /*<! Chunk is the beginning of the frame */
+    bool last;                       /*<! Chunk is the end of the frame */
+    uint16_t len;
+    char data[DISCORD_GW_WS_BUFFER_SIZE];
+} discord_gw_chunk_t;
+
+/**
+ * @brief Decode stage of the gateway pipeline. Websocket task only copies received chunks into the buffers from the pool,
+ *        and decode task inflates and parses them
+ */
+typedef struct {
+    TaskHandle_t task;
+    QueueHandle_t pool;              /*<! Free chunks */
+    QueueHandle_t chunks;            /*<! Received chunks waiting for decoding */
+    discord_gw_chunk_t* buffers;
+} discord_gw_decode_t;
+
+/**
+ * @brief Ring for payloads which do not fit into the queue (DISCORD_QUEUE_SPILL policy).
+ *        Payloads in the ring are always newer than payloads in the queue
+ */
+typedef struct {
+    portMUX_TYPE lock;
+    discord_payload_t** items;       /*<! Allocated in PSRAM if available */
+    uint16_t size;
+    uint16_t head;                   /*<! Index of the oldest payload */
+    uint16_t len;
+} discord_gw_overflow_t;
+
+/**
+ * @brief Payloads dropped because the queue (or the queue of event worker) was full
+ */
+typedef struct {
+    portMUX_TYPE lock;               /*<! Payloads are dropped by websocket task and discord task, counters are read by any task */
+    uint32_t count[_DISCORD_EVENT_MAX]; /*<! Number of dropped payloads per event */
+    uint32_t unreported;             /*<! Drops since the last warning */
+    uint64_t reported_ms;            /*<! Time of the last warning */
+} discord_dropped_t;
+
+/**
+ * @brief Scratch for coalescing the queue (DISCORD_QUEUE_COALESCE policy). Queue is drained into the items
+ *        and refilled while the lock keeps discord task away from it
+ */
+typedef struct {
+    SemaphoreHandle_t lock;
+    discord_payload_t** items;       /*<! Allocated once, has the size of the queue */
+} discord_gw_coalesce_t;
+
+#define DISCORD_LATENCY_SAMPLES          32
+
+typedef struct {
+    portMUX_TYPE lock;               /*<! Statistics are updated by discord task and read by any task */
+    uint16_t samples[DISCORD_LATENCY_SAMPLES]; /*<! Ring buffer with round-trip times (in ms) of the last heartbeats */
+    uint8_t head;                    /*<! Index of the next sample */
+    uint8_t len;                     /*<! Number of valid samples */
+    uint32_t last_ms;
+    uint32_t missed;
+} discord_latency_t;
+
 typedef struct {
     bool running;
     int interval;
-    uint64_t tick_ms;
+    uint64_t tick_ms;                /*<! Time when the last heartbeat is sent */
     bool received_ack;
+    uint64_t ack_tick_ms;            /*<! Time when the last ACK is received. Taken before the payload is queued, so it does not include delay of the discord task */
+    esp_timer_handle_t timer;        /*<! Periodic timer which notifies discord task when heartbeat needs to be sent */
+    discord_latency_t latency;
 } discord_heartbeater_t;
 
+typedef struct {
+    uint32_t route;                  /*<! Hash of the route (method and path with major parameter) */
+    int remaining;                   /*<! Number of requests that can be made until reset. -1 if unknown */
+    uint64_t reset_ms;               /*<! Tick when the bucket resets */
+    uint64_t used_ms;                /*<! Tick of the last use */
+} discord_api_bucket_t;
+
+typedef struct {
+    discord_api_bucket_t buckets[DISCORD_API_BUCKETS];
+    uint64_t global_reset_ms;        /*<! Tick until all requests are blocked (after global 429) */
+    uint64_t window_ms;              /*<! Start of the current one second window of global limit */
+    uint8_t window_count;            /*<! Number of requests in the current window */
+    int remaining;                   /*<! X-RateLimit-Remaining of the current response. -1 if missing */
+    int reset_after_ms;              /*<! X-RateLimit-Reset-After of the current response. -1 if missing */
+    int retry_after_ms;              /*<! Retry-After of the current response. -1 if missing */
+    bool global;                     /*<! X-RateLimit-Global of the current response */
+} discord_api_ratelimit_t;
+
+typedef struct {
+    esp_event_handler_t handler;
+    void* arg;
+} discord_event_subscription_t;
+
+/**
+ * @brief Handlers of one event. Full array is replaced by the bigger copy (under handlers lock),
+ *        so handlers are never accessed through reallocated memory
+ */
+typedef struct {
+    discord_event_subscription_t* items;
+    size_t len;
+    size_t capacity;
+} discord_event_handlers_t;
+
+/**
+ * @brief Handler which is being invoked by discord task or event worker. Unregistration waits until it returns
+ */
+typedef struct {
+    TaskHandle_t task;
+    esp_event_handler_t handler;     /*<! NULL if task does not invoke any handler */
+} discord_event_invocation_t;
+
+typedef struct {
+    discord_handle_t client;
+    uint8_t index;
+    TaskHandle_t task;
+    QueueHandle_t queue;             /*<! Dispatch payloads which are handled by this worker */
+} discord_event_worker_t;
+
 typedef esp_err_t(*discord_event_handler_t)(discord_handle_t client, discord_event_t event, discord_event_data_ptr_t data_ptr);
 
 struct discord {
@@ -93,13 +306,29 @@ struct discord {
     discord_gateway_state_t state;
     TaskHandle_t task_handle;
     QueueHandle_t queue;
-    esp_event_loop_handle_t event_handle;
+    QueueHandle_t control_queue;                    /*<! Priority lane for control payloads (HELLO, HEARTBEAT_ACK), so they don't wait behind dispatches */
+    discord_gw_overflow_t overflow;
+    discord_gw_coalesce_t coalesce;
+    discord_dropped_t dropped;
     discord_event_handler_t event_handler;
+    portMUX_TYPE handlers_lock;                     /*<! Handlers are registered by any task and invoked by discord task and workers */
+    discord_event_handlers_t handlers[_DISCORD_EVENT_MAX];
+    discord_event_handlers_t any_handlers;          /*<! Handlers registered for DISCORD_EVENT_ANY */
+    discord_event_invocation_t invocations[DISCORD_EVENT_WORKERS_MAX + 1]; /*<! Guarded by handlers lock. Discord task first, then workers */
+    discord_event_worker_t* workers;                /*<! Tasks which run handlers of channel events (config->event_workers) */
     discord_config_t* config;
     SemaphoreHandle_t gw_lock;
     esp_websocket_client_handle_t ws;
-    SemaphoreHandle_t api_lock;
-    esp_http_client_handle_t http;
+    discord_gw_outbox_t gw_outbox;                  /*<! Payloads which wait for gateway rate limit. Guarded by gw_lock */
+    discord_gw_presence_t gw_presence;
+    esp_timer_handle_t gw_identify_timer;           /*<! One-shot timer which notifies discord task when identify is allowed */
+    uint8_t gw_identify_key;                        /*<! Identify rate limit key of the shard */
+    uint64_t gw_identify_at;                        /*<! Identify slot reserved by the delayed identify. 0 if identify is not pending */
+    uint64_t gw_identify_prev_ms;                   /*<! Next allowed identify before the slot was reserved. Restored if the slot is released */
+    discord_gw_info_t gw_info;
+    SemaphoreHandle_t api_lock;                     /*<! Created with the client and kept across reconnections (api itself is destroyed on disconnection) */
+    esp_http_client_handle_t http;                 /*<! Persistent (keep-alive) client for api requests */
+    esp_http_client_handle_t cdn_http;             /*<! Persistent (keep-alive) client for attachment downloads */
     char* api_buffer;
     int api_buffer_size;
     bool api_buffer_record;
@@ -109,11 +338,20 @@ struct discord {
     void* api_download_arg;
     size_t api_download_total;
     size_t api_download_offset;
+    discord_api_ratelimit_t api_ratelimit;
+    esp_err_t (*api_stream_handler)(const char* data, size_t len, void* arg);  /*<! Stream handler of the request in progress */
+    void* api_stream_arg;
+    esp_err_t api_stream_status;                    /*<! First error returned by stream handler */
+    QueueHandle_t api_queue;                        /*<! Queue of asynchronous requests */
+    TaskHandle_t api_task;                          /*<! Worker which sends asynchronous requests */
     discord_heartbeater_t heartbeater;
     discord_session_t* session;
     int last_sequence_number;
     char* gw_buffer;
     int gw_buffer_len;
+    struct discord_gw_inflater* gw_inflater;
+    struct discord_payload_decoder* gw_decoder;
+    discord_gw_decode_t gw_decode;
     discord_gateway_close_reason_t close_reason;
     discord_close_code_t close_code;
     discord_ota_handle_t ota;
@@ -0,0 +1,45 @@
+#ifndef _DISCORD_PRIVATE_EVENTS_H_
+#define _DISCORD_PRIVATE_EVENTS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "discord.h"
+#include "_discord.h"
+#include "_models.h"
+
+/**
+ * @brief Init handler registry and create event workers (if they are enabled in config)
+ */
+esp_err_t dcev_init(discord_handle_t client);
+/**
+ * @brief Wait for the workers to handle submitted events, delete them and free registered handlers
+ */
+void dcev_destroy(discord_handle_t client);
+/**
+ * @return true if the current task is one of the workers
+ */
+bool dcev_is_worker(discord_handle_t client);
+/**
+ * @brief Register handler of the event. Registering the same handler again only updates the argument
+ */
+esp_err_t dcev_register(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler, void* event_handler_arg);
+esp_err_t dcev_unregister(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler);
+/**
+ * @brief Invoke handlers of the event (DISCORD_EVENT_ANY handlers first) directly in the current task
+ */
+esp_err_t dcev_dispatch(discord_handle_t client, discord_event_t event, discord_event_data_ptr_t data_ptr);
+/**
+ * @brief Pass dispatch payload to the worker which handles events of its channel, so the events of the same channel
+ *        are handled in order and events of different channels in parallel. Payload will be automatically freed.
+ *        Function never blocks. If the queue of the worker is full, event is dropped and counted (discord_get_dropped_events)
+ * @return ESP_ERR_NO_MEM if event is dropped, ESP_ERR_NOT_SUPPORTED if workers are not enabled (payload is not freed in this case)
+ */
+esp_err_t dcev_submit(discord_handle_t client, discord_payload_t* payload);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -11,17 +11,78 @@ extern "C" {
 
 esp_err_t dcgw_init(discord_handle_t client);
 /**
- * @brief Send payload (serialized to json) to gateway. Payload will be automatically freed
+ * @brief Send payload (serialized to json) to gateway. Payload will be automatically freed.
+ *        If gateway rate limit is exhausted, payload is queued and sent later by discord task (control payloads first).
+ *        Pending presence update is replaced by the newer one
  */
 esp_err_t dcgw_send(discord_handle_t client, discord_payload_t* payload);
+/**
+ * @brief Send queued payloads which are allowed by gateway rate limit
+ */
+esp_err_t dcgw_outbox_flush(discord_handle_t client);
+/**
+ * @brief Set presence which will be sent to gateway. Presence is ignored if it's the same as the last one
+ * @param json Serialized presence. Function takes the ownership
+ */
+esp_err_t dcgw_presence_set(discord_handle_t client, char* json);
+/**
+ * @brief Send pending presence if the bot is connected and the update window is elapsed, otherwise schedule it
+ */
+esp_err_t dcgw_presence_flush(discord_handle_t client);
+/**
+ * @brief Identify (start new session). If identify rate limit of the shard is exhausted, identify is delayed
+ *        and sent later by discord task
+ * @param delay_ms Minimal delay of identify. 0 to identify as soon as rate limit allows it
+ */
+esp_err_t dcgw_identify(discord_handle_t client, uint32_t delay_ms);
+/**
+ * @brief Send identify without waiting for rate limit
+ */
+esp_err_t dcgw_identify_send(discord_handle_t client);
+/**
+ * @brief Make sure that gateway info is known. It's loaded from NVS or fetched (GET /gateway/bot) once per client.
+ *        Fetched info is cached in NVS
+ */
+esp_err_t dcgw_info_load(discord_handle_t client);
 bool dcgw_is_open(discord_handle_t client);
 esp_err_t dcgw_open(discord_handle_t client);
 esp_err_t dcgw_start(discord_handle_t client);
+/**
+ * @brief Check if there is a session (with sequence number) which can be resumed on the next connection
+ */
+bool dcgw_can_resume(discord_handle_t client);
+/**
+ * @brief Drop current session and sequence number. Next connection will use IDENTIFY instead of RESUME
+ */
+esp_err_t dcgw_session_invalidate(discord_handle_t client);
 esp_err_t dcgw_close(discord_handle_t client, discord_gateway_close_reason_t reason);
 esp_err_t dcgw_get_close_desc(discord_handle_t client, char** out_description);
+/**
+ * @brief Decide how to reconnect after the gateway closed the connection with given code
+ */
+discord_reconnect_rule_t dcgw_reconnect_rule(discord_close_code_t code);
+/**
+ * @brief Exponential backoff with full jitter. Random delays spread reconnections of many devices
+ *        which are disconnected at the same time (ex: access point reboot)
+ * @return Random delay between 0 and min(reconnect_max_ms, reconnect_base_ms * 2^attempt)
+ */
+uint32_t dcgw_reconnect_delay(discord_handle_t client, uint8_t attempt);
 esp_err_t dcgw_destroy(discord_handle_t client);
 esp_err_t dcgw_queue_flush(discord_handle_t client);
-esp_err_t dcgw_heartbeat_send_if_expired(discord_handle_t client);
+/**
+ * @brief Count the payload as dropped (discord_get_dropped_events) and free it. Warning is logged once per burst of drops
+ */
+void dcgw_drop_payload(discord_handle_t client, discord_payload_t* payload);
+/**
+ * @brief Take the oldest control payload, or the oldest dispatch payload from the queue (or from the overflow ring) if there is no control one
+ * @return true if payload is taken
+ */
+bool dcgw_queue_receive(discord_handle_t client, discord_payload_t** out_payload);
+esp_err_t dcgw_heartbeat_send(discord_handle_t client);
+/**
+ * @brief Calculate statistics from the heartbeat round-trip times of the latest heartbeats
+ */
+esp_err_t dcgw_get_latency(discord_handle_t client, discord_gateway_latency_t* out_latency);
 esp_err_t dcgw_handle_payload(discord_handle_t client, discord_payload_t* payload);
 
 #ifdef __cplusplus
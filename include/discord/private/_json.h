@@ -2,6 +2,8 @@
 #define _DISCORD_PRIVATE_JSON_H_
 
 #include "cJSON.h"
+#include "discord/private/_json_stream.h"
+#include "discord/private/_json_schema.h"
 #include "discord/private/_models.h"
 #include "discord/session.h"
 #include "discord/user.h"
@@ -13,6 +15,7 @@
 #include "discord/role.h"
 #include "discord/attachment.h"
 #include "discord/voice_state.h"
+#include "discord/presence.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -53,9 +56,75 @@ extern "C" {
 #define discord_json_list_deserialize_(obj_name, json, length, out_length) \
     discord_json_list_deserialize(discord_ ##obj_name ##_t, discord_ ##obj_name ##_from_cjson, json, length, out_length)
 
+extern const dcjs_schema_t discord_user_schema;
+extern const dcjs_schema_t discord_member_schema;
+extern const dcjs_schema_t discord_attachment_schema;
+extern const dcjs_schema_t discord_message_schema;
+extern const dcjs_schema_t discord_emoji_schema;
+extern const dcjs_schema_t discord_message_reaction_schema;
+extern const dcjs_schema_t discord_voice_state_schema;
+extern const dcjs_schema_t discord_session_schema;
+extern const dcjs_schema_t discord_guild_schema;
+extern const dcjs_schema_t discord_channel_schema;
+extern const dcjs_schema_t discord_role_schema;
+
 cJSON* discord_payload_to_cjson(discord_payload_t* payload);
 discord_payload_t* discord_payload_from_cjson(cJSON* cjson);
 
+typedef struct discord_payload_decoder* discord_payload_decoder_handle_t;
+
+/**
+ * @brief Function which decides whether the data of the dispatch event needs to be decoded
+ */
+typedef bool(*discord_payload_decoder_filter_t)(discord_event_t event, void* arg);
+
+/**
+ * @brief Create streaming payload decoder. Payload JSON can be fed in arbitrary chunks (fragments)
+ * @param max_token_len Maximum length of a single JSON token (string, number or key)
+ * @param filter Optional filter. If event data is rejected, "d" member is only validated and payload will have NULL data
+ * @param filter_arg User argument passed to the filter
+ */
+discord_payload_decoder_handle_t discord_payload_decoder_create(size_t max_token_len, discord_payload_decoder_filter_t filter, void* filter_arg);
+esp_err_t discord_payload_decoder_feed(discord_payload_decoder_handle_t decoder, const char* data, size_t len);
+/**
+ * @brief Finish decoding of the fed payload and prepare the decoder for the next one
+ * @return Decoded payload or NULL if payload is not valid
+ */
+discord_payload_t* discord_payload_decoder_finish(discord_payload_decoder_handle_t decoder);
+/**
+ * @brief Discard fed data
+ */
+void discord_payload_decoder_reset(discord_payload_decoder_handle_t decoder);
+void discord_payload_decoder_destroy(discord_payload_decoder_handle_t decoder);
+
+typedef struct discord_list_decoder* discord_list_decoder_handle_t;
+
+/**
+ * @brief Function which receives decoded list item. Item is freed after function returns
+ * @return true to continue decoding, false to stop (rest of the list is ignored)
+ */
+typedef bool(*discord_list_visitor_t)(void* item, void* arg);
+
+/**
+ * @brief Create streaming decoder of JSON array of objects described by the schema. Array can be fed in arbitrary chunks,
+ *        and every object is decoded (allocated on heap) as soon as it is parsed, so the whole JSON is never buffered
+ * @param max_token_len Maximum length of a single JSON token (string, number or key)
+ * @param visitor Optional. If provided, items are passed to it one by one instead of being collected into the list
+ * @param visitor_arg User argument passed to the visitor
+ */
+discord_list_decoder_handle_t discord_list_decoder_create(const dcjs_schema_t* schema, size_t max_token_len, discord_list_visitor_t visitor, void* visitor_arg);
+esp_err_t discord_list_decoder_feed(discord_list_decoder_handle_t decoder, const char* data, size_t len);
+/**
+ * @brief Finish decoding and take the decoded list. Decoder is not owner of the list anymore
+ * @param out_list List of decoded objects (NULL if array is empty or visitor is used). Can be NULL
+ * @param out_len Length of the list. Can be NULL
+ */
+esp_err_t discord_list_decoder_finish(discord_list_decoder_handle_t decoder, void*** out_list, int* out_len);
+/**
+ * @brief Destroy the decoder and free all of the objects which are not taken
+ */
+void discord_list_decoder_destroy(discord_list_decoder_handle_t decoder);
+
 discord_payload_data_t discord_dispatch_event_data_from_cjson(discord_event_t e, cJSON* cjson);
 
 cJSON* discord_heartbeat_to_cjson(discord_heartbeat_t* heartbeat);
@@ -64,6 +133,12 @@ cJSON* discord_identify_properties_to_cjson(discord_identify_properties_t* prope
 
 cJSON* discord_identify_to_cjson(discord_identify_t* identify);
 
+cJSON* discord_resume_to_cjson(discord_resume_t* resume);
+
+cJSON* discord_presence_to_cjson(discord_presence_t* presence);
+
+discord_gateway_bot_t* discord_gateway_bot_from_cjson(cJSON* root);
+
 discord_session_t* discord_session_from_cjson(cJSON* root);
 
 discord_user_t* discord_user_from_cjson(cJSON* root);
@@ -0,0 +1,124 @@
+#ifndef _DISCORD_PRIVATE_JSON_SCHEMA_H_
+#define _DISCORD_PRIVATE_JSON_SCHEMA_H_
+
+#include <stddef.h>
+#include "esp_err.h"
+#include "discord/private/_json_stream.h"
+#include "earena.h"
+#include "discord/snowflake.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DCJS_FIELD_STRING,         /*<! char* */
+    DCJS_FIELD_INT,            /*<! Integer (or enum) of any size */
+    DCJS_FIELD_BOOL,           /*<! bool */
+    DCJS_FIELD_SNOWFLAKE,      /*<! discord_snowflake_t, decoded from the decimal string */
+    DCJS_FIELD_OBJECT,         /*<! Pointer to the struct described by nested schema */
+    DCJS_FIELD_ARRAY           /*<! Array of elements (see element type) with separate length field */
+} dcjs_field_type_t;
+
+typedef struct dcjs_schema dcjs_schema_t;
+
+typedef struct {
+    const char* key;
+    dcjs_field_type_t type;
+    size_t offset;
+    uint8_t size;                  /*<! Size of the integer field */
+    const dcjs_schema_t* schema;   /*<! Schema of the object or of the array element */
+    dcjs_field_type_t element;     /*<! Type of the array element. Strings and objects are stored as pointers, snowflakes by value */
+    size_t len_offset;             /*<! Offset of the array length field */
+    uint8_t len_size;              /*<! Size of the array length field */
+} dcjs_field_t;
+
+struct dcjs_schema {
+    size_t size;                   /*<! Size of the struct */
+    const dcjs_field_t* fields;
+    uint8_t fields_len;
+    void (*init)(void* obj);       /*<! Optional function which sets default values of newly allocated (zeroed) struct */
+};
+
+#define _dcjs_member_size(model, member) sizeof(((model*) 0)->member)
+
+#define DCJS_FIELD_STR(model, member, json_key) \
+    { .key = json_key, .type = DCJS_FIELD_STRING, .offset = offsetof(model, member) }
+
+#define DCJS_FIELD_NUM(model, member, json_key) \
+    { .key = json_key, .type = DCJS_FIELD_INT, .offset = offsetof(model, member), .size = _dcjs_member_size(model, member) }
+
+#define DCJS_FIELD_BOOLEAN(model, member, json_key) \
+    { .key = json_key, .type = DCJS_FIELD_BOOL, .offset = offsetof(model, member) }
+
+#define DCJS_FIELD_ID(model, member, json_key) \
+    { .key = json_key, .type = DCJS_FIELD_SNOWFLAKE, .offset = offsetof(model, member) }
+
+#define DCJS_FIELD_OBJ(model, member, json_key, obj_schema) \
+    { .key = json_key, .type = DCJS_FIELD_OBJECT, .offset = offsetof(model, member), .schema = obj_schema }
+
+#define _DCJS_FIELD_ARR(model, member, len_member, json_key, element_type, element_schema) \
+    { .key = json_key, .type = DCJS_FIELD_ARRAY, .offset = offsetof(model, member), .element = element_type, .schema = element_schema, \
+      .len_offset = offsetof(model, len_member), .len_size = _dcjs_member_size(model, len_member) }
+
+#define DCJS_FIELD_ARR(model, member, len_member, json_key, element_schema) \
+    _DCJS_FIELD_ARR(model, member, len_member, json_key, DCJS_FIELD_OBJECT, element_schema)
+
+#define DCJS_FIELD_ARR_STR(model, member, len_member, json_key) \
+    _DCJS_FIELD_ARR(model, member, len_member, json_key, DCJS_FIELD_STRING, NULL)
+
+#define DCJS_FIELD_ARR_ID(model, member, len_member, json_key) \
+    _DCJS_FIELD_ARR(model, member, len_member, json_key, DCJS_FIELD_SNOWFLAKE, NULL)
+
+#define DCJS_SCHEMA_(model, fields_arr, init_fnc) \
+    { .size = sizeof(model), .fields = fields_arr, .fields_len = sizeof(fields_arr) / sizeof(fields_arr[0]), .init = init_fnc }
+
+#define DCJS_SCHEMA(model, fields_arr) DCJS_SCHEMA_(model, fields_arr, NULL)
+
+typedef struct {
+    const dcjs_schema_t* schema;   /*<! Schema of the object which is decoded on this depth. NULL if the value is skipped */
+    const dcjs_field_t* array;     /*<! Array field which is filled if the value on this depth is an array */
+    void* obj;                     /*<! Decoded object, or owner of the array field */
+} dcjs_decoder_frame_t;
+
+/**
+ * @brief Decoder which maps parser events directly into the struct described by the schema (without intermediate tree).
+ *        Unknown members are skipped
+ */
+typedef struct {
+    const dcjs_schema_t* schema;
+    uint8_t depth;                 /*<! Depth of the decoded object in the document */
+    earena_handle_t arena;         /*<! Arena from which is decoded object allocated. NULL to use heap */
+    void* result;
+    dcjs_decoder_frame_t frames[DCJS_MAX_DEPTH];
+} dcjs_decoder_t;
+
+/**
+ * @brief Start decoding of the object which is on the given depth
+ * @param arena Arena for all of the object allocations. If NULL, object is allocated on heap and needs to be freed with dcjs_schema_free
+ *              (or model free function). Otherwise the object is released only by destroying the arena
+ */
+void dcjs_decoder_begin(dcjs_decoder_t* decoder, const dcjs_schema_t* schema, uint8_t depth, earena_handle_t arena);
+/**
+ * @brief Handle parser event. Events of the values out of decoded object should not be passed
+ */
+esp_err_t dcjs_decoder_handle(dcjs_decoder_t* decoder, const dcjs_event_t* event);
+/**
+ * @brief Take the decoded object. Decoder is not owner of the object anymore
+ * @return Decoded object or NULL if object is not decoded
+ */
+void* dcjs_decoder_end(dcjs_decoder_t* decoder);
+/**
+ * @brief Free partially decoded object (in case of error). Object allocated from the arena is just abandoned
+ */
+void dcjs_decoder_abort(dcjs_decoder_t* decoder);
+/**
+ * @brief Free object which is decoded by the schema
+ */
+void dcjs_schema_free(const dcjs_schema_t* schema, void* obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef _DISCORD_PRIVATE_JSON_STREAM_H_
+#define _DISCORD_PRIVATE_JSON_STREAM_H_
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DCJS_MAX_DEPTH 32
+
+typedef enum {
+    DCJS_EVENT_OBJECT_START,
+    DCJS_EVENT_OBJECT_END,
+    DCJS_EVENT_ARRAY_START,
+    DCJS_EVENT_ARRAY_END,
+    DCJS_EVENT_STRING,
+    DCJS_EVENT_NUMBER,
+    DCJS_EVENT_TRUE,
+    DCJS_EVENT_FALSE,
+    DCJS_EVENT_NULL
+} dcjs_event_type_t;
+
+typedef struct {
+    dcjs_event_type_t type;
+    const char* key;         /*<! Name of the member if value is a member of an object, otherwise NULL */
+    const char* value;       /*<! Null-terminated (unescaped) value of string or raw value of number. NULL for other events */
+    size_t value_len;
+    uint8_t depth;           /*<! Depth of the value. Root value has depth 0 */
+} dcjs_event_t;
+
+/**
+ * @brief Parser event handler. Returning anything else than ESP_OK will stop the parsing
+ */
+typedef esp_err_t(*dcjs_handler_t)(const dcjs_event_t* event, void* arg);
+
+typedef struct dcjs_parser* dcjs_parser_handle_t;
+
+/**
+ * @brief Create push (SAX-style) JSON parser. Document can be fed in arbitrary chunks,
+ *        and only the token which is currently parsed (string, key or number) is buffered
+ * @param max_token_len Maximum length of a single token
+ * @param handler Function which will be invoked for every parsed value
+ * @param arg User argument passed to the handler
+ * @return Parser handle or NULL on failure (no memory)
+ */
+dcjs_parser_handle_t dcjs_create(size_t max_token_len, dcjs_handler_t handler, void* arg);
+/**
+ * @brief Parse next chunk of the document
+ * @return ESP_OK on success. Once when error occurs, every further call will return the same error until the reset
+ */
+esp_err_t dcjs_feed(dcjs_parser_handle_t parser, const char* data, size_t len);
+/**
+ * @brief Signal end of the document
+ * @return ESP_OK if complete document is parsed
+ */
+esp_err_t dcjs_finish(dcjs_parser_handle_t parser);
+/**
+ * @brief Prepare parser for the new document
+ */
+void dcjs_reset(dcjs_parser_handle_t parser);
+void dcjs_destroy(dcjs_parser_handle_t parser);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
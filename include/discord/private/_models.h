@@ -3,6 +3,7 @@
 
 #include "cJSON.h"
 #include "discord.h"
+#include "earena.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,6 +18,7 @@ typedef struct {
     discord_payload_data_t d;
     int s;
     discord_event_t t;
+    earena_handle_t _arena;        /*<! If set, payload data is allocated from this arena and it's released at once */
 } discord_payload_t;
 
 typedef struct {
@@ -35,8 +37,32 @@ typedef struct {
     char* token;
     int intents;
     discord_identify_properties_t* properties;
+    int shard_id;
+    int shard_count;               /*<! 0 if sharding is not used */
 } discord_identify_t;
 
+typedef struct {
+    char* token;
+    char* session_id;
+    int seq;
+} discord_resume_t;
+
+typedef struct {
+    bool resumable;
+} discord_invalid_session_t;
+
+/**
+ * @brief Response of GET /gateway/bot
+ */
+typedef struct {
+    char* url;
+    int shards;                    /*<! Recommended number of shards */
+    int total;                     /*<! Total number of session starts (identifies) allowed per reset period */
+    int remaining;                 /*<! Remaining number of session starts */
+    int reset_after;               /*<! Number of milliseconds after which the limit resets */
+    int max_concurrency;           /*<! Number of identify requests allowed per 5 seconds */
+} discord_gateway_bot_t;
+
 void discord_payload_free(discord_payload_t* payload);
 
 void discord_dispatch_event_data_free(discord_payload_t* payload);
@@ -47,6 +73,12 @@ void discord_identify_properties_free(discord_identify_properties_t* properties)
 
 void discord_identify_free(discord_identify_t* identify);
 
+void discord_resume_free(discord_resume_t* resume);
+
+void discord_invalid_session_free(discord_invalid_session_t* invalid_session);
+
+void discord_gateway_bot_free(discord_gateway_bot_t* gateway_bot);
+
 #ifdef __cplusplus
 }
 #endif
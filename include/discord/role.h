@@ -6,18 +6,30 @@ extern "C" {
 #endif
 
 #include "discord.h"
+#include "discord/snowflake.h"
 
 typedef uint8_t discord_role_len_t;
 
 typedef struct {
-    char* id;
+    discord_snowflake_t id;
     char* name;
     discord_role_len_t position;
     char* permissions;
 } discord_role_t;
 
-esp_err_t discord_role_get_all(discord_handle_t client, const char* guild_id, discord_role_t*** out_roles, discord_role_len_t* out_length);
-esp_err_t discord_role_is_in_ids_list(discord_role_t* role, char** role_ids, discord_role_len_t role_ids_len, bool* out_result);
+/**
+ * @brief Function which receives roles one by one. Role is freed after function returns
+ * @return true to continue, false to stop the iteration
+ */
+typedef bool(*discord_role_visitor_t)(discord_role_t* role, void* arg);
+
+esp_err_t discord_role_get_all(discord_handle_t client, discord_snowflake_t guild_id, discord_role_t*** out_roles, discord_role_len_t* out_length);
+/**
+ * @brief Iterate over guild roles while they are received. Only one role is in memory at a time
+ * @return ESP_OK on success (also if iteration is stopped by the visitor)
+ */
+esp_err_t discord_role_foreach(discord_handle_t client, discord_snowflake_t guild_id, discord_role_visitor_t visitor, void* arg);
+esp_err_t discord_role_is_in_ids_list(discord_role_t* role, discord_snowflake_t* role_ids, discord_role_len_t role_ids_len, bool* out_result);
 esp_err_t discord_role_sort_list(discord_role_t** roles, discord_role_len_t len);
 void discord_role_free(discord_role_t* role);
 
@@ -0,0 +1,55 @@
+#ifndef _DISCORD_SNOWFLAKE_H_
+#define _DISCORD_SNOWFLAKE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+/**
+ * @brief Discord unique ID (snowflake). Discord transfers it as a decimal string, but it's always 64-bit unsigned integer
+ */
+typedef uint64_t discord_snowflake_t;
+
+#define DISCORD_SNOWFLAKE_NULL        ((discord_snowflake_t) 0)   /*<! Missing (or null) ID */
+#define DISCORD_SNOWFLAKE_STR_SIZE    (21)                        /*<! Maximum length of the decimal representation with null terminator */
+#define DISCORD_SNOWFLAKE_FMT         PRIu64                      /*<! Format specifier for printf-like functions (ex: "id=%" DISCORD_SNOWFLAKE_FMT) */
+
+/**
+ * @brief Shard which receives events of the guild
+ */
+#define DISCORD_SNOWFLAKE_SHARD(guild_id, shard_count) ((uint16_t) (((guild_id) >> 22) % (shard_count)))
+
+/**
+ * @brief Format snowflake into temporary buffer which is valid until the end of enclosing block
+ *        (ex: estr_cat("/channels/", DISCORD_SNOWFLAKE_STR(channel_id), "/messages"))
+ */
+#define DISCORD_SNOWFLAKE_STR(snowflake) discord_snowflake_to_str(snowflake, (char[DISCORD_SNOWFLAKE_STR_SIZE]) { 0 })
+
+/**
+ * @brief Parse snowflake from decimal string
+ * @return Snowflake or DISCORD_SNOWFLAKE_NULL if string is NULL or it isn't valid snowflake
+ */
+discord_snowflake_t discord_snowflake_from_str(const char* str);
+
+/**
+ * @brief Parse snowflake from first n characters of decimal string
+ * @return Snowflake or DISCORD_SNOWFLAKE_NULL if string is NULL or it isn't valid snowflake
+ */
+discord_snowflake_t discord_snowflake_from_strn(const char* str, size_t n);
+
+/**
+ * @brief Format snowflake as decimal string
+ * @param buffer Buffer with at least DISCORD_SNOWFLAKE_STR_SIZE bytes
+ * @return Pointer to the buffer
+ */
+char* discord_snowflake_to_str(discord_snowflake_t snowflake, char* buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -7,9 +7,10 @@ extern "C" {
 
 #include "discord.h"
 #include "discord/guild.h"
+#include "discord/snowflake.h"
 
 typedef struct {
-    char* id;
+    discord_snowflake_t id;
     bool bot;
     char* username;
     char* discriminator;
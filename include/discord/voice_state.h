@@ -7,16 +7,17 @@ extern "C" {
 
 #include "discord.h"
 #include "discord/member.h"
+#include "discord/snowflake.h"
 
 typedef struct {
-    char* guild_id;            /*!< The guild id this voice state is for */
-    char* channel_id;          /*!< The channel id this user is connected to */
-    char* user_id;             /*!< The user id this voice state is for */
-    discord_member_t* member;  /*!< The guild member this voice state is for */
-    bool deaf;                 /*!< Whether this user is deafened by the server */
-    bool mute;                 /*!< Whether this user is muted by the server */
-    bool self_deaf;            /*!< Whether this user is locally deafened */
-    bool self_mute;            /*!< Whether this user is locally muted */
+    discord_snowflake_t guild_id;    /*!< The guild id this voice state is for */
+    discord_snowflake_t channel_id;  /*!< The channel id this user is connected to. DISCORD_SNOWFLAKE_NULL if user is not connected */
+    discord_snowflake_t user_id;     /*!< The user id this voice state is for */
+    discord_member_t* member;        /*!< The guild member this voice state is for */
+    bool deaf;                       /*!< Whether this user is deafened by the server */
+    bool mute;                       /*!< Whether this user is muted by the server */
+    bool self_deaf;                  /*!< Whether this user is locally deafened */
+    bool self_mute;                  /*!< Whether this user is locally muted */
 } discord_voice_state_t;
 
 void discord_voice_state_free(discord_voice_state_t* voice_state);
@@ -0,0 +1,54 @@
+#ifndef _CUTILS_EARENA_H_
+#define _CUTILS_EARENA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * @brief Arena (bump) allocator. Memory is allocated from the contiguous blocks,
+ *        and it cannot be released partially - all of the allocations are released at once by destroying the arena
+ */
+typedef struct earena* earena_handle_t;
+
+/**
+ * @brief Create the arena
+ * @param block_size Size of the first block. Every next block is doubled (or big enough for the allocation)
+ * @return Arena handle or NULL on failure (no memory)
+ */
+earena_handle_t earena_create(size_t block_size);
+
+/**
+ * @brief Allocate zero-initialized memory from the arena
+ * @return Pointer to allocated memory or NULL on failure (no memory)
+ */
+void* earena_calloc(earena_handle_t arena, size_t size);
+
+/**
+ * @brief Resize the memory which is allocated from the arena. If the memory is the last allocation and there is enough space,
+ *        it will be extended in place, otherwise new memory will be allocated and old content copied into it
+ * @param ptr Memory previously allocated from the arena (or NULL)
+ * @param size Current size of the memory
+ * @param new_size New size of the memory
+ * @return Pointer to resized memory or NULL on failure (no memory). Old memory remains valid on failure
+ */
+void* earena_realloc(earena_handle_t arena, void* ptr, size_t size, size_t new_size);
+
+/**
+ * @brief Copy n characters of the string into the arena
+ * @return Pointer to null-terminated copy or NULL on failure (no memory)
+ */
+char* earena_strndup(earena_handle_t arena, const char* str, size_t n);
+
+/**
+ * @brief Release all of the memory allocated from the arena and the arena itself
+ */
+void earena_destroy(earena_handle_t arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -7,6 +7,7 @@ extern "C" {
 
 #include "cutils.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -14,6 +15,8 @@ extern "C" {
 #define CU_ERR_ESTR_INVALID_WHITESPACE      (CU_ERR_ESTR_BASE - 1)
 #define CU_ERR_ESTR_INVALID_OUT_OF_BOUNDS   (CU_ERR_ESTR_BASE - 2)
 
+#define ESTR_HASH_INIT                      (2166136261u)   /*<! Initial value for estrn_hash */
+
 typedef struct {
     bool length;
     unsigned int minlen;
@@ -98,6 +101,16 @@ bool estrn_is_digit_only(const char* str, size_t n);
  */
 size_t estrn_chrcnt(const char* str, char chr, size_t n);
 
+/**
+ * @brief Hash characters of string with 32-bit FNV-1a.
+ *        String can be hashed in parts by passing the hash of the previous part
+ * @param hash ESTR_HASH_INIT, or hash of the previous part
+ * @param str String (does not need to be null-terminated)
+ * @param n Number of characters that needs to be hashed
+ * @return Hash of the string
+ */
+uint32_t estrn_hash(uint32_t hash, const char* str, size_t n);
+
 /**
  * @brief Split string using character. Resulting list needs to be freed (cu_list_free can be used)
  * @param str String that is gonna be used for splitting
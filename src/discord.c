@@ -1,6 +1,7 @@
 #include "discord.h"
 #include "discord/private/_gateway.h"
 #include "discord/private/_api.h"
+#include "discord/private/_events.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -12,8 +13,6 @@
 
 #define _dc_default(val, default) (val > 0 ? val : default)
 
-#define DISCORD_STOPPED_BIT (1 << 0)
-
 DISCORD_LOG_DEFINE_BASE();
 
 ESP_EVENT_DEFINE_BASE(DISCORD_EVENTS);
@@ -22,11 +21,22 @@ static discord_config_t* dc_config_copy(const discord_config_t* config) {
     discord_config_t* clone = cu_ctor(discord_config_t,
         .intents = config->intents,
         .gateway_buffer_size = _dc_default(config->gateway_buffer_size, DISCORD_DEFAULT_GW_BUFFER_SIZE),
+        .gateway_compression = config->gateway_compression,
+        .gateway_decode = config->gateway_decode,
         .api_buffer_size = _dc_default(config->api_buffer_size, DISCORD_DEFAULT_API_BUFFER_SIZE),
         .api_timeout_ms = _dc_default(config->api_timeout_ms, DISCORD_DEFAULT_API_TIMEOUT_MS),
         .queue_size = _dc_default(config->queue_size, DISCORD_DEFAULT_QUEUE_SIZE),
+        .queue_policy = config->queue_policy,
+        .queue_overflow_size = _dc_default(config->queue_overflow_size, DISCORD_DEFAULT_QUEUE_OVERFLOW_SIZE),
         .task_stack_size = _dc_default(config->task_stack_size, DISCORD_DEFAULT_TASK_STACK_SIZE),
-        .task_priority = _dc_default(config->task_priority, DISCORD_DEFAULT_TASK_PRIORITY)
+        .task_priority = _dc_default(config->task_priority, DISCORD_DEFAULT_TASK_PRIORITY),
+        .event_workers = config->event_workers,
+        .shard_id = config->shard_id,
+        .shard_count = config->shard_count,
+        .max_concurrency = config->max_concurrency,
+        .reconnect_base_ms = _dc_default(config->reconnect_base_ms, DISCORD_DEFAULT_RECONNECT_BASE_MS),
+        .reconnect_max_ms = _dc_default(config->reconnect_max_ms, DISCORD_DEFAULT_RECONNECT_MAX_MS),
+        .reconnect_max_attempts = config->reconnect_max_attempts
     );
 
     // todo: memcheck
@@ -52,22 +62,6 @@ static void dc_config_free(discord_config_t* config) {
     free(config);
 }
 
-static esp_err_t dc_dispatch_event(discord_handle_t client, discord_event_t event, discord_event_data_ptr_t data_ptr) {
-    DISCORD_LOG_FOO();
-
-    esp_err_t err;
-
-    discord_event_data_t event_data;
-    event_data.client = client;
-    event_data.ptr = data_ptr;
-
-    if ((err = esp_event_post_to(client->event_handle, DISCORD_EVENTS, event, &event_data, sizeof(discord_event_data_t), portMAX_DELAY)) != ESP_OK) {
-        return err;
-    }
-
-    return esp_event_loop_run(client->event_handle, 0);
-}
-
 static esp_err_t dc_shutdown(discord_handle_t client) {
     if(!client)
         return ESP_ERR_INVALID_ARG;
@@ -75,27 +69,42 @@ static esp_err_t dc_shutdown(discord_handle_t client) {
     DISCORD_LOG_FOO();
 
     client->running = false;
+    dcapi_worker_stop(client);
     dcgw_destroy(client);
     dcapi_destroy(client);
-    discord_session_free(client->session);
-    client->session = NULL;
+    dcgw_session_invalidate(client);
 
     return ESP_OK;
 }
 
+/**
+ * @brief Wait for given time or until logout is requested
+ */
+static void dc_sleep(discord_handle_t client, uint32_t ms) {
+    uint64_t deadline = discord_tick_ms() + ms;
+    uint64_t now;
+
+    while(client->running && (now = discord_tick_ms()) < deadline) {
+        TickType_t ticks = (deadline - now) / portTICK_PERIOD_MS;
+        xTaskNotifyWait(0, UINT32_MAX, NULL, ticks > 0 ? ticks : 1);
+    }
+}
+
 static void dc_task(void* arg) {
     DISCORD_LOG_FOO();
 
     discord_handle_t client = (discord_handle_t) arg;
     bool restart = false;
+    bool immediate = false;
     bool is_shutted_down = false;
+    uint8_t reconnect_attempts = 0;
 
     xEventGroupClearBits(client->bits, DISCORD_STOPPED_BIT);
 
     while(client->running) {
         switch(client->state) {
             case DISCORD_STATE_CONNECTED:
-                dcgw_heartbeat_send_if_expired(client);
+                reconnect_attempts = 0;
                 break;
 
             case DISCORD_STATE_DISCONNECTED:
@@ -112,15 +121,25 @@ static void dc_task(void* arg) {
                         client->close_code == DISCORD_CLOSEOP_NO_CODE ? "NULL" : (close_desc ? close_desc : "NULL")
                     );
 
-                    if(client->close_code == DISCORD_CLOSEOP_AUTHENTICATION_FAILED) {
-                        dc_shutdown(client);     // shutdown only on invalid token
+                    discord_reconnect_rule_t rule = dcgw_reconnect_rule(client->close_code);
+
+                    if(rule == DISCORD_RECONNECT_NEVER) {
+                        dc_shutdown(client);     // close code is kept, so it can be checked by discord_get_close_code
                         is_shutted_down = true;
                     } else {
-                        restart = true;          // restart in any other case
+                        restart = true;
+                        immediate = rule != DISCORD_RECONNECT_BACKOFF;
+
+                        if(rule == DISCORD_RECONNECT_NEW_SESSION) {
+                            dcgw_session_invalidate(client); // session cannot be resumed, new one needs to be started
+                        }
+
                         client->close_code = DISCORD_CLOSEOP_NO_CODE;
                     }
-                } else if(DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED == client->close_reason) {
+                } else if(DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED == client->close_reason
+                    || DISCORD_CLOSE_REASON_RECONNECT == client->close_reason) {
                     restart = true;
+                    immediate = true;
                 } else {
                     DISCORD_LOGW("Disconnection requested but not handled");
                     dc_shutdown(client);
@@ -139,23 +158,63 @@ static void dc_task(void* arg) {
 
         if(client->state >= DISCORD_STATE_CONNECTING) {
             discord_payload_t* payload = NULL;
+            uint32_t notification = 0;
+            bool received = dcgw_queue_receive(client, &payload);
+
+            // block until something happens (payload, heartbeat or state change) only if there is nothing to handle
+            xTaskNotifyWait(0, UINT32_MAX, &notification, received ? 0 : portMAX_DELAY);
 
-            if(xQueueReceive(client->queue, &payload, 1000 / portTICK_PERIOD_MS) == pdPASS) { // poll every 1 sec
+            if(received) {
                 dcgw_handle_payload(client, payload);
             }
+
+            if(notification & DISCORD_NOTIFY_HEARTBEAT) { // after the payload, which can be ACK of the previous heartbeat
+                dcgw_heartbeat_send(client);
+            }
+
+            if(notification & DISCORD_NOTIFY_OUTBOX) {
+                dcgw_outbox_flush(client);
+            }
+
+            if(notification & DISCORD_NOTIFY_PRESENCE) {
+                dcgw_presence_flush(client);
+            }
+
+            if(notification & DISCORD_NOTIFY_IDENTIFY) {
+                dcgw_identify_send(client);
+            }
         } else if(client->state <= DISCORD_STATE_DISCONNECTED) {
             dcapi_destroy(client);
             dcgw_close(client, client->state == DISCORD_STATE_ERROR ? DISCORD_CLOSE_REASON_ERROR : client->close_reason); // do not modify reason if no error
 
             if(restart || client->state == DISCORD_STATE_ERROR) {
+                if(client->config->reconnect_max_attempts > 0 && reconnect_attempts >= client->config->reconnect_max_attempts) {
+                    DISCORD_LOGE("Giving up after %d reconnection attempts", reconnect_attempts);
+                    break;
+                }
+
+                if(immediate && reconnect_attempts == 0 && dcgw_can_resume(client)) { // first attempt to resume is immediate
+                    DISCORD_LOGI("Reconnecting to resume the session...");
+                } else {
+                    uint32_t delay = dcgw_reconnect_delay(client, reconnect_attempts);
+                    DISCORD_LOGI("Reconnecting in %d ms (attempt %d)...", (int) delay, reconnect_attempts + 1);
+                    dc_sleep(client, delay);
+                }
+
                 restart = false;
-                DISCORD_LOGI("Restarting discord in 10 sec...");
-                vTaskDelay(10000 / portTICK_PERIOD_MS);
-                DISCORD_EVENT_FIRE(DISCORD_EVENT_RECONNECTING, NULL);
-                dcgw_start(client);
+                immediate = false;
+
+                if(reconnect_attempts < UINT8_MAX) {
+                    reconnect_attempts++;
+                }
+
+                if(client->running) {
+                    DISCORD_EVENT_FIRE(DISCORD_EVENT_RECONNECTING, NULL);
+                    dcgw_start(client);
+                }
             }
         } else {
-            vTaskDelay(125 / portTICK_PERIOD_MS);
+            xTaskNotifyWait(0, UINT32_MAX, NULL, portMAX_DELAY); // wait for the state change
         }
     }
 
@@ -164,6 +223,7 @@ static void dc_task(void* arg) {
     }
     
     DISCORD_EVENT_FIRE(DISCORD_EVENT_DISCONNECTED, NULL);
+    client->task_handle = NULL;
     xEventGroupSetBits(client->bits, DISCORD_STOPPED_BIT);
     DISCORD_LOGD("Task exit.");
     vTaskDelete(NULL);
@@ -195,10 +255,14 @@ discord_handle_t discord_create(const discord_config_t* config) {
         return NULL;
     }
 
-    esp_event_loop_args_t event_args = {
-        .queue_size = 1,
-        .task_name = NULL // no task will be created
-    };
+    if(client->config->shard_count > 0 && client->config->shard_id >= client->config->shard_count) {
+        DISCORD_LOGE("Fail to create Discord. Invalid shard %d/%d", client->config->shard_id, client->config->shard_count);
+        discord_destroy(client);
+        return NULL;
+    }
+
+    portMUX_INITIALIZE(&client->heartbeater.latency.lock);
+    portMUX_INITIALIZE(&client->dropped.lock);
 
     if(!(client->bits = xEventGroupCreate())) {
         DISCORD_LOGE("Fail to create bits group");
@@ -208,13 +272,25 @@ discord_handle_t discord_create(const discord_config_t* config) {
 
     xEventGroupSetBits(client->bits, DISCORD_STOPPED_BIT);
 
-    if (esp_event_loop_create(&event_args, &client->event_handle) != ESP_OK) {
-        DISCORD_LOGE("Fail to create event handler");
+    if(!(client->api_lock = xSemaphoreCreateMutex())) {
+        DISCORD_LOGE("Fail to create api lock");
         discord_destroy(client);
         return NULL;
     }
 
-    client->event_handler = &dc_dispatch_event;
+    if(!(client->gw_presence.lock = xSemaphoreCreateMutex())) {
+        DISCORD_LOGE("Fail to create presence lock");
+        discord_destroy(client);
+        return NULL;
+    }
+
+    client->event_handler = &dcev_dispatch;
+
+    if(dcev_init(client) != ESP_OK) {
+        DISCORD_LOGE("Fail to init events");
+        discord_destroy(client);
+        return NULL;
+    }
 
     if(dcgw_init(client) != ESP_OK) {
         DISCORD_LOGE("Fail to init gateway");
@@ -279,13 +355,41 @@ esp_err_t discord_get_close_code(discord_handle_t client, discord_close_code_t*
     return ESP_OK;
 }
 
+esp_err_t discord_get_gateway_latency(discord_handle_t client, discord_gateway_latency_t* out_latency) {
+    if(!client || !out_latency) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return dcgw_get_latency(client, out_latency);
+}
+
+esp_err_t discord_get_dropped_events(discord_handle_t client, discord_event_t event, uint32_t* out_count) {
+    if(!client || !out_count || (event != DISCORD_EVENT_ANY && (event < 0 || event >= _DISCORD_EVENT_MAX))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&client->dropped.lock);
+    if(event != DISCORD_EVENT_ANY) {
+        *out_count = client->dropped.count[event];
+    } else {
+        *out_count = 0;
+
+        for(int i = 0; i < _DISCORD_EVENT_MAX; i++) {
+            *out_count += client->dropped.count[i];
+        }
+    }
+    portEXIT_CRITICAL(&client->dropped.lock);
+
+    return ESP_OK;
+}
+
 esp_err_t discord_register_events(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler, void* event_handler_arg) {
     if(!client)
         return ESP_ERR_INVALID_ARG;
     
     DISCORD_LOG_FOO();
     
-    return esp_event_handler_register_with(client->event_handle, DISCORD_EVENTS, event, event_handler, event_handler_arg);
+    return dcev_register(client, event, event_handler, event_handler_arg);
 }
 
 esp_err_t discord_unregister_events(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler) {
@@ -293,11 +397,7 @@ esp_err_t discord_unregister_events(discord_handle_t client, discord_event_t eve
         return ESP_ERR_INVALID_ARG;
     }
 
-    if(!client->event_handle) {
-        return ESP_OK;
-    }
-
-    return esp_event_handler_unregister_with(client->event_handle, DISCORD_EVENTS, event, event_handler);
+    return dcev_unregister(client, event, event_handler);
 }
 
 esp_err_t discord_logout(discord_handle_t client) {
@@ -311,12 +411,18 @@ esp_err_t discord_logout(discord_handle_t client) {
         return ESP_FAIL;
     }
 
+    if (dcapi_is_worker(client)) { // discord task would wait for the api worker to stop
+        DISCORD_LOGE("Cannot logout from request callback");
+        return ESP_FAIL;
+    }
+
     if(!client->running) {
         DISCORD_LOGW("Not logged in");
         return ESP_OK;
     }
 
     client->running = false;
+    DISCORD_NOTIFY(DISCORD_NOTIFY_STATE);
     xEventGroupWaitBits(client->bits, DISCORD_STOPPED_BIT, pdFALSE, pdTRUE, portMAX_DELAY); // wait for the discord task to be stopped
 
     return ESP_OK;
@@ -329,17 +435,29 @@ esp_err_t discord_destroy(discord_handle_t client) {
     
     DISCORD_LOG_FOO();
     
-    if (xTaskGetCurrentTaskHandle() == client->task_handle) {
+    if (xTaskGetCurrentTaskHandle() == client->task_handle || dcev_is_worker(client)) {
         DISCORD_LOGE("Cannot destroy from event handler");
         return ESP_FAIL;
     }
 
+    if (dcapi_is_worker(client)) {
+        DISCORD_LOGE("Cannot destroy from request callback");
+        return ESP_FAIL;
+    }
+
     discord_logout(client);
     client->event_handler = NULL;
+    dcev_destroy(client);
+    dcapi_destroy(client);
+
+    if(client->api_lock) {
+        vSemaphoreDelete(client->api_lock);
+        client->api_lock = NULL;
+    }
 
-    if(client->event_handle) {
-        esp_event_loop_delete(client->event_handle);
-        client->event_handle = NULL;
+    if(client->gw_presence.lock) {
+        vSemaphoreDelete(client->gw_presence.lock);
+        client->gw_presence.lock = NULL;
     }
 
     if(client->bits) {
@@ -351,6 +469,8 @@ esp_err_t discord_destroy(discord_handle_t client) {
 
     dc_config_free(client->config);
     client->config = NULL;
+    free(client->gw_presence.pending);
+    free(client->gw_presence.sent);
     free(client);
 
     return ESP_OK;
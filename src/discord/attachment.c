@@ -23,7 +23,6 @@ void discord_attachment_free(discord_attachment_t* attachment)
     if(!attachment)
         return;
     
-    free(attachment->id);
     free(attachment->filename);
     free(attachment->content_type);
     free(attachment->url);
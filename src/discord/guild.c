@@ -13,19 +13,38 @@ esp_err_t discord_guild_get_channels(discord_handle_t client, discord_guild_t* g
         return ESP_ERR_INVALID_ARG;
     }
 
-    esp_err_t err = ESP_OK;
-    discord_api_response_t* res = NULL;
-    
-    if((err = dcapi_get(client, estr_cat("/guilds/", guild->id, "/channels"), NULL, &res)) != ESP_OK) {
+    esp_err_t err = dcapi_get_list(
+        client,
+        estr_cat("/guilds/", DISCORD_SNOWFLAKE_STR(guild->id), "/channels"),
+        &discord_channel_schema,
+        (void***) out_channels,
+        out_length
+    );
+
+    if(err != ESP_OK) {
         DISCORD_LOGE("Fail to fetch channels");
-        return err;
     }
-    
-    if(dcapi_response_is_success(res) && res->data_len > 0) {
-        *out_channels = discord_json_list_deserialize_(channel, res->data, res->data_len, out_length);
+
+    return err;
+}
+
+esp_err_t discord_guild_foreach_channel(discord_handle_t client, discord_guild_t* guild, discord_channel_visitor_t visitor, void* arg) {
+    if(!client || !guild || !visitor) {
+        DISCORD_LOGE("Invalid args");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = dcapi_foreach(
+        client,
+        estr_cat("/guilds/", DISCORD_SNOWFLAKE_STR(guild->id), "/channels"),
+        &discord_channel_schema,
+        (discord_list_visitor_t) visitor,
+        arg
+    );
+
+    if(err != ESP_OK) {
+        DISCORD_LOGE("Fail to fetch channels");
     }
-    
-    dcapi_response_free(client, res);
 
     return err;
 }
@@ -34,7 +53,6 @@ void discord_guild_free(discord_guild_t* guild) {
     if(!guild)
         return;
 
-    free(guild->id);
     free(guild->name);
     free(guild->permissions);
     free(guild);
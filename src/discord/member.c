@@ -7,7 +7,7 @@
 
 DISCORD_LOG_DEFINE_BASE();
 
-esp_err_t discord_member_get(discord_handle_t client, char* guild_id, char* user_id, discord_member_t** out_member) {
+esp_err_t discord_member_get(discord_handle_t client, discord_snowflake_t guild_id, discord_snowflake_t user_id, discord_member_t** out_member) {
     if(! client || ! guild_id || ! user_id || ! out_member) {
         DISCORD_LOGE("Invalid args");
         return ESP_ERR_INVALID_ARG;
@@ -19,7 +19,7 @@ esp_err_t discord_member_get(discord_handle_t client, char* guild_id, char* user
     
     if((err = dcapi_get(
         client,
-        estr_cat("/guilds/", guild_id, "/members/", user_id),
+        estr_cat("/guilds/", DISCORD_SNOWFLAKE_STR(guild_id), "/members/", DISCORD_SNOWFLAKE_STR(user_id)),
         NULL,
         &res
     )) != ESP_OK) {
@@ -36,90 +36,78 @@ esp_err_t discord_member_get(discord_handle_t client, char* guild_id, char* user
     return err;
 }
 
-static bool dc_member_permissions_calc(discord_handle_t client, discord_member_t* member, discord_role_t** roles, discord_role_len_t roles_len, uint64_t permissions) {
-    discord_role_sort_list(roles, roles_len);
+typedef struct {
+    discord_member_t* member;
+    discord_snowflake_t guild_id;
+    uint64_t o_ring;                               /*<! Permissions of @everyone and member roles */
+} dc_member_permissions_ctx_t;
 
-    uint64_t o_ring = strtoull(roles[0]->permissions, NULL, 10); // @everyone permissions
+static bool dc_member_permissions_visitor(discord_role_t* role, void* arg) {
+    dc_member_permissions_ctx_t* ctx = (dc_member_permissions_ctx_t*) arg;
+    bool in_ids = role->id == ctx->guild_id; // @everyone role has the same id as the guild
 
-    if((o_ring & DISCORD_PERMISSION_ADMINISTRATOR) == DISCORD_PERMISSION_ADMINISTRATOR) { // @everyone has administrator
-        return true;
+    if(! in_ids) {
+        discord_role_is_in_ids_list(role, ctx->member->roles, ctx->member->_roles_len, &in_ids);
     }
 
-    bool in_ids = false;
-    if(member->_roles_len > 0) {
-        for(discord_role_len_t i = 1; i < roles_len; i++) {
-            discord_role_is_in_ids_list(roles[i], member->roles, member->_roles_len, &in_ids);
-            
-            if(! in_ids) { // member does not have this role
-                continue;
-            }
-
-            o_ring |= strtoull(roles[i]->permissions, NULL, 10);
-
-            if((o_ring & DISCORD_PERMISSION_ADMINISTRATOR) == DISCORD_PERMISSION_ADMINISTRATOR) {
-                return true;
-            }
-        }
+    if(in_ids && role->permissions) {
+        ctx->o_ring |= strtoull(role->permissions, NULL, 10);
     }
-    
-    return (o_ring & permissions) == permissions;
+
+    return (ctx->o_ring & DISCORD_PERMISSION_ADMINISTRATOR) != DISCORD_PERMISSION_ADMINISTRATOR; // stop when administrator
 }
 
-esp_err_t discord_member_has_permissions(discord_handle_t client, discord_member_t* member, char* guild_id, uint64_t permissions, bool* out_result) {
+esp_err_t discord_member_has_permissions(discord_handle_t client, discord_member_t* member, discord_snowflake_t guild_id, uint64_t permissions, bool* out_result) {
     if(! client || ! member || ! guild_id || ! out_result) {
         DISCORD_LOGE("Invalid args");
         return ESP_ERR_INVALID_ARG;
     }
 
-    discord_role_len_t len;
-    discord_role_t** roles = NULL;
-    esp_err_t err = discord_role_get_all(client, guild_id, &roles, &len);
+    dc_member_permissions_ctx_t ctx = { .member = member, .guild_id = guild_id };
+    esp_err_t err = discord_role_foreach(client, guild_id, dc_member_permissions_visitor, &ctx);
 
     if(err != ESP_OK) {
         return err;
     }
-    
-    bool res = dc_member_permissions_calc(client, member, roles, len, permissions);
-    cu_list_tfreex(roles, discord_role_len_t, len, discord_role_free);
 
-    *out_result = res;
+    *out_result = (ctx.o_ring & DISCORD_PERMISSION_ADMINISTRATOR) == DISCORD_PERMISSION_ADMINISTRATOR
+        || (ctx.o_ring & permissions) == permissions;
     return ESP_OK;
 }
 
-esp_err_t discord_member_has_role_name(discord_handle_t client, discord_member_t* member, const char* guild_id, const char* role_name, bool* out_result) {
+typedef struct {
+    const char* role_name;
+    discord_snowflake_t role_id;                   /*<! Id of found role */
+} dc_member_role_name_ctx_t;
+
+static bool dc_member_role_name_visitor(discord_role_t* role, void* arg) {
+    dc_member_role_name_ctx_t* ctx = (dc_member_role_name_ctx_t*) arg;
+
+    if(estr_eq(role->name, ctx->role_name)) {
+        ctx->role_id = role->id;
+        return false;
+    }
+
+    return true;
+}
+
+esp_err_t discord_member_has_role_name(discord_handle_t client, discord_member_t* member, discord_snowflake_t guild_id, const char* role_name, bool* out_result) {
     if(! client || ! member || ! guild_id || ! role_name || ! out_result) {
         DISCORD_LOGE("Invalid args");
         return ESP_ERR_INVALID_ARG;
     }
 
-    discord_role_len_t len;
-    discord_role_t** roles = NULL;
-    
-    esp_err_t err = discord_role_get_all(client, guild_id, &roles, &len);
+    dc_member_role_name_ctx_t ctx = { .role_name = role_name };
+    esp_err_t err = discord_role_foreach(client, guild_id, dc_member_role_name_visitor, &ctx);
 
     if(err != ESP_OK) {
         return err;
     }
 
-    discord_role_t* required_role = NULL;
-
-    for(discord_role_len_t i = 0; i < len; i++) {
-        if(estr_eq(roles[i]->name, role_name)) {
-            required_role = roles[i];
-            break;
-        }
-    }
-
-    if(required_role == NULL) { // role doesn't exist in guild
-        cu_list_tfreex(roles, discord_role_len_t, len, discord_role_free);
-        *out_result = false;
-        return ESP_OK;
-    }
-
-    // role exist in guild, check if role is assigned to member
+    // if role exist in guild, check if role is assigned to member
     bool result = false;
-    for(discord_role_len_t i = 0; i < member->_roles_len; i++) {
-        if(estr_eq(required_role->id, member->roles[i])) {
+    for(discord_role_len_t i = 0; ctx.role_id && i < member->_roles_len; i++) {
+        if(ctx.role_id == member->roles[i]) {
             result = true;
             break;
         }
@@ -135,6 +123,6 @@ void discord_member_free(discord_member_t* member) {
 
     free(member->nick);
     free(member->permissions);
-    cu_list_free(member->roles, member->_roles_len);
+    free(member->roles);
     free(member);
 }
\ No newline at end of file
@@ -7,26 +7,28 @@
 
 DISCORD_LOG_DEFINE_BASE();
 
+/**
+ * @brief Create multipart which references attachment data. If attachment owns the data, ownership is moved to the multipart
+ */
 static discord_api_multipart_t* discord_message_create_multipart_from_attachment(discord_attachment_t* attachment)
 {
-    return cu_ctor(discord_api_multipart_t,
-        .name                  = estr_cat("files[", attachment->id, "]"),
+    discord_api_multipart_t* multipart = cu_ctor(discord_api_multipart_t,
+        .name                  = estr_cat("files[", DISCORD_SNOWFLAKE_STR(attachment->id), "]"),
         .mime_type             = strdup(attachment->content_type),
         .filename              = strdup(attachment->filename),
         .data                  = attachment->_data,
         .len                   = attachment->size,
         .data_should_be_freed  = attachment->_data_should_be_freed,
     );
-}
 
-esp_err_t discord_message_send(discord_handle_t client, discord_message_t* message, discord_message_t** out_result) {
-    if(! client || ! message || ! message->channel_id) {
-        DISCORD_LOGE("Invalid args");
-        return ESP_ERR_INVALID_ARG;
-    }
+    attachment->_data_should_be_freed = false;
+
+    return multipart;
+}
 
+static discord_api_request_t* discord_message_send_request(discord_message_t* message) {
     discord_api_request_t* req = dcapi_create_request(
-        estr_cat("/channels/", message->channel_id, "/messages"),
+        estr_cat("/channels/", DISCORD_SNOWFLAKE_STR(message->channel_id), "/messages"),
         discord_json_serialize(message)
     );
 
@@ -34,16 +36,25 @@ esp_err_t discord_message_send(discord_handle_t client, discord_message_t* messa
         dcapi_add_multipart_to_request(discord_message_create_multipart_from_attachment(message->attachments[i]), req);
     }
 
-    discord_api_response_t* res = NULL;
-    esp_err_t err = dcapi_request(client, HTTP_METHOD_POST, req, &res);
-    discord_api_request_free(req);
+    return req;
+}
 
-    if(err != ESP_OK) {
-        return err;
-    }
+static discord_api_request_t* discord_message_react_request(discord_message_t* message, const char* emoji) {
+    char* _emoji = estr_url_encode(emoji);
+    discord_api_request_t* req = dcapi_create_request(
+        estr_cat("/channels/", DISCORD_SNOWFLAKE_STR(message->channel_id), "/messages/", DISCORD_SNOWFLAKE_STR(message->id), "/reactions/", _emoji, "/@me"),
+        NULL
+    );
+    free(_emoji);
 
+    return req;
+}
+
+/**
+ * @brief Check response of sent message and deserialize the message from it (if out_result is provided)
+ */
+static esp_err_t discord_message_from_response(discord_api_response_t* res, discord_message_t** out_result) {
     if(! dcapi_response_is_success(res)) {
-        dcapi_response_free(client, res);
         return ESP_ERR_INVALID_RESPONSE;
     }
 
@@ -54,24 +65,98 @@ esp_err_t discord_message_send(discord_handle_t client, discord_message_t* messa
             *out_result = discord_json_deserialize_(message, res->data, res->data_len);
         }
     }
-    
-    dcapi_response_free(client, res);
+
     return ESP_OK;
 }
 
+esp_err_t discord_message_send(discord_handle_t client, discord_message_t* message, discord_message_t** out_result) {
+    if(! client || ! message || ! message->channel_id) {
+        DISCORD_LOGE("Invalid args");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    discord_api_request_t* req = discord_message_send_request(message);
+    discord_api_response_t* res = NULL;
+    esp_err_t err = dcapi_request(client, HTTP_METHOD_POST, req, &res);
+    discord_api_request_free(req);
+
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    err = discord_message_from_response(res, out_result);
+    dcapi_response_free(client, res);
+
+    return err;
+}
+
 esp_err_t discord_message_react(discord_handle_t client, discord_message_t* message, const char* emoji) {
     if(!client || !message || !message->id || !message->channel_id) {
         DISCORD_LOGE("Invalid args");
         return ESP_FAIL;
     }
 
-    char* _emoji = estr_url_encode(emoji);
-    esp_err_t err = dcapi_put(client, estr_cat("/channels/", message->channel_id, "/messages/", message->id, "/reactions/", _emoji, "/@me"), NULL, NULL);
-    free(_emoji);
+    discord_api_request_t* req = discord_message_react_request(message, emoji);
+    esp_err_t err = dcapi_request(client, HTTP_METHOD_PUT, req, NULL);
+    discord_api_request_free(req);
+
+    return err;
+}
+
+typedef struct {
+    discord_message_callback_t callback;
+    void* arg;
+} discord_message_async_t;
+
+static void discord_message_on_response(discord_handle_t client, esp_err_t err, discord_api_response_t* res, void* arg) {
+    discord_message_async_t* ctx = (discord_message_async_t*) arg;
+    discord_message_t* result = NULL;
+
+    if(err == ESP_OK) {
+        err = discord_message_from_response(res, res->data_len > 0 ? &result : NULL);
+    }
+
+    ctx->callback(client, err, result, ctx->arg);
+
+    discord_message_free(result);
+    free(ctx);
+}
+
+static esp_err_t discord_message_request_async(discord_handle_t client, discord_api_request_t* req, esp_http_client_method_t method, discord_message_callback_t callback, void* arg) {
+    discord_message_async_t* ctx = NULL;
+
+    if(callback) {
+        ctx = cu_ctor(discord_message_async_t, .callback = callback, .arg = arg);
+        // todo: memcheck
+    }
+
+    esp_err_t err = dcapi_request_async(client, method, req, ctx ? discord_message_on_response : NULL, ctx);
+
+    if(err != ESP_OK) {
+        free(ctx);
+    }
 
     return err;
 }
 
+esp_err_t discord_message_send_async(discord_handle_t client, discord_message_t* message, discord_message_callback_t callback, void* arg) {
+    if(! client || ! message || ! message->channel_id) {
+        DISCORD_LOGE("Invalid args");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return discord_message_request_async(client, discord_message_send_request(message), HTTP_METHOD_POST, callback, arg);
+}
+
+esp_err_t discord_message_react_async(discord_handle_t client, discord_message_t* message, const char* emoji, discord_message_callback_t callback, void* arg) {
+    if(!client || !message || !message->id || !message->channel_id) {
+        DISCORD_LOGE("Invalid args");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return discord_message_request_async(client, discord_message_react_request(message, emoji), HTTP_METHOD_PUT, callback, arg);
+}
+
 esp_err_t discord_message_download_attachment(discord_handle_t client, discord_message_t* message, uint8_t attachment_index, discord_download_handler_t download_handler, void* arg) {
     if(!client || !message || !message->attachments) {
         DISCORD_LOGE("Invalid args");
@@ -148,10 +233,7 @@ esp_err_t discord_message_add_attachment(discord_message_t* message, discord_att
     message->attachments = realloc(message->attachments, ++message->_attachments_len * sizeof(discord_attachment_t*));
     int index = message->_attachments_len - 1;
 
-    free(attachment->id);
-    int length = snprintf(NULL, 0, "%d", index);
-    attachment->id = malloc((length + 1) * sizeof(char));
-    snprintf(attachment->id, length + 1, "%d", index);
+    attachment->id = index;
 
     message->attachments[index] = attachment;
     return ESP_OK;
@@ -173,11 +255,8 @@ void discord_message_free(discord_message_t* message) {
     if(!message)
         return;
     
-    free(message->id);
     free(message->content);
-    free(message->channel_id);
     discord_user_free(message->author);
-    free(message->guild_id);
     discord_member_free(message->member);
     cu_list_freex(message->attachments, message->_attachments_len, discord_attachment_free);
     cu_list_freex(message->embeds, message->_embeds_len, discord_embed_free);
@@ -0,0 +1,18 @@
+#include "discord/presence.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_gateway.h"
+#include "discord/private/_json.h"
+
+esp_err_t discord_presence_update(discord_handle_t client, const discord_presence_t* presence) {
+    if(!client || !presence) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char* json = discord_json_serialize_((discord_presence_t*) presence, discord_presence_to_cjson);
+
+    if(!json) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    return dcgw_presence_set(client, json);
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "discord/private/_api.h"
 #include "cutils.h"
 #include "estr.h"
+#include <strings.h>
 
 DISCORD_LOG_DEFINE_BASE();
 
@@ -32,11 +33,11 @@ esp_err_t dcapi_response_free(discord_handle_t client, discord_api_response_t* r
     return ESP_OK;
 }
 
-static esp_err_t dcapi_flush_http(discord_handle_t client, bool record) {
+static esp_err_t dcapi_flush_http(discord_handle_t client, esp_http_client_handle_t http, bool record) {
     DISCORD_LOG_FOO();
 
     client->api_buffer_record = record;
-    esp_err_t err = esp_http_client_flush_response(client->http, NULL);
+    esp_err_t err = esp_http_client_flush_response(http, NULL);
     client->api_buffer_record = false;
 
     if(! record) {
@@ -46,10 +47,185 @@ static esp_err_t dcapi_flush_http(discord_handle_t client, bool record) {
     return err;
 }
 
+uint32_t dcapi_route_hash(esp_http_client_method_t method, const char* uri) {
+    uint32_t hash = ESTR_HASH_INIT ^ (uint32_t) method;
+
+    const char* segment = uri;
+    const char* prev = NULL;
+    size_t prev_len = 0;
+
+    while(segment && *segment && *segment != '?') {
+        if(*segment == '/') {
+            segment++;
+            continue;
+        }
+
+        size_t len = strcspn(segment, "/?");
+        bool numeric = strspn(segment, "0123456789") >= len;
+        bool major = prev && (
+            (prev_len == 8 && strncmp(prev, "channels", 8) == 0) ||
+            (prev_len == 6 && strncmp(prev, "guilds", 6) == 0) ||
+            (prev_len == 8 && strncmp(prev, "webhooks", 8) == 0)
+        );
+
+        const char* part = numeric && !major ? ":id" : segment;
+        size_t part_len = numeric && !major ? 3 : len;
+
+        hash = estrn_hash(hash, "/", 1);
+        hash = estrn_hash(hash, part, part_len);
+
+        if(len == 9 && strncmp(segment, "reactions", 9) == 0) {
+            break;
+        }
+
+        prev = segment;
+        prev_len = len;
+        segment += len;
+    }
+
+    return hash;
+}
+
+discord_api_bucket_t* dcapi_bucket_get(discord_handle_t client, uint32_t route, bool create) {
+    discord_api_bucket_t* lru = NULL;
+
+    for(uint8_t i = 0; i < DISCORD_API_BUCKETS; i++) {
+        discord_api_bucket_t* bucket = &client->api_ratelimit.buckets[i];
+
+        if(bucket->route == route && bucket->used_ms > 0) {
+            return bucket;
+        }
+
+        if(!lru || bucket->used_ms < lru->used_ms) {
+            lru = bucket;
+        }
+    }
+
+    if(!create) {
+        return NULL;
+    }
+
+    *lru = (discord_api_bucket_t) { .route = route, .remaining = -1, .used_ms = discord_tick_ms() };
+
+    return lru;
+}
+
+/**
+ * @brief Check global and bucket limits. If the request can be sent now, one request is counted against the limits
+ * @return Number of milliseconds to wait before the request can be sent, or 0 if it can be sent now
+ */
+static uint32_t dcapi_ratelimit_delay(discord_handle_t client, uint32_t route) {
+    discord_api_ratelimit_t* rl = &client->api_ratelimit;
+    uint64_t now = discord_tick_ms();
+
+    if(rl->global_reset_ms > now) {
+        return rl->global_reset_ms - now;
+    }
+
+    if(now - rl->window_ms >= 1000) {
+        rl->window_ms = now;
+        rl->window_count = 0;
+    }
+
+    if(rl->window_count >= DISCORD_API_GLOBAL_LIMIT) {
+        return rl->window_ms + 1000 - now;
+    }
+
+    discord_api_bucket_t* bucket = dcapi_bucket_get(client, route, false);
+
+    if(bucket) {
+        if(bucket->reset_ms <= now) {
+            bucket->remaining = -1; // bucket is reset, actual value will come with response
+        } else if(bucket->remaining == 0) {
+            return bucket->reset_ms - now;
+        } else if(bucket->remaining > 0) {
+            bucket->remaining--;
+        }
+
+        bucket->used_ms = now;
+    }
+
+    rl->window_count++;
+
+    return 0;
+}
+
+static int dcapi_ratelimit_header_ms(const char* value) {
+    return (int) (strtod(value, NULL) * 1000);
+}
+
+static void dcapi_ratelimit_on_header(discord_handle_t client, const char* key, const char* value) {
+    discord_api_ratelimit_t* rl = &client->api_ratelimit;
+
+    if(!key || !value)
+        return;
+
+    if(strcasecmp(key, "X-RateLimit-Remaining") == 0) {
+        rl->remaining = atoi(value);
+    } else if(strcasecmp(key, "X-RateLimit-Reset-After") == 0) {
+        rl->reset_after_ms = dcapi_ratelimit_header_ms(value);
+    } else if(strcasecmp(key, "Retry-After") == 0) {
+        rl->retry_after_ms = dcapi_ratelimit_header_ms(value);
+    } else if(strcasecmp(key, "X-RateLimit-Global") == 0) {
+        rl->global = strcasecmp(value, "true") == 0;
+    }
+}
+
+/**
+ * @brief Update limits from the headers of received response
+ */
+static void dcapi_ratelimit_update(discord_handle_t client, uint32_t route, int code) {
+    discord_api_ratelimit_t* rl = &client->api_ratelimit;
+    uint64_t now = discord_tick_ms();
+
+    if(code == 429) {
+        int retry_after_ms = rl->retry_after_ms >= 0 ? rl->retry_after_ms : (rl->reset_after_ms >= 0 ? rl->reset_after_ms : 1000);
+
+        DISCORD_LOGW("Rate limited (global=%d, retry_after=%d ms)", rl->global, retry_after_ms);
+
+        if(rl->global) {
+            rl->global_reset_ms = now + retry_after_ms;
+        } else {
+            discord_api_bucket_t* bucket = dcapi_bucket_get(client, route, true);
+            bucket->remaining = 0;
+            bucket->reset_ms = now + retry_after_ms;
+        }
+
+        return;
+    }
+
+    if(rl->remaining < 0) { // route without rate limit info
+        return;
+    }
+
+    discord_api_bucket_t* bucket = dcapi_bucket_get(client, route, true);
+    bucket->remaining = rl->remaining;
+    bucket->reset_ms = now + (rl->reset_after_ms > 0 ? rl->reset_after_ms : 0);
+    bucket->used_ms = now;
+}
+
 static esp_err_t dcapi_on_http_event(esp_http_client_event_t* evt) {
     discord_handle_t client = (discord_handle_t) evt->user_data;
 
-    if(evt->event_id != HTTP_EVENT_ON_DATA || evt->data_len <= 0 || !client->api_buffer_record)
+    if(evt->event_id == HTTP_EVENT_ON_HEADER) {
+        dcapi_ratelimit_on_header(client, evt->header_key, evt->header_value);
+        return ESP_OK;
+    }
+
+    if(evt->event_id != HTTP_EVENT_ON_DATA || evt->data_len <= 0)
+        return ESP_OK;
+
+    int code = esp_http_client_get_status_code(evt->client);
+
+    if(client->api_stream_handler && code >= 200 && code <= 299) {
+        if(client->api_stream_status == ESP_OK) {
+            client->api_stream_status = client->api_stream_handler((const char*) evt->data, evt->data_len, client->api_stream_arg);
+        }
+
+        return ESP_OK;
+    }
+
+    if(!client->api_buffer_record)
         return ESP_OK;
 
     DISCORD_LOGD(
@@ -125,28 +301,19 @@ static esp_err_t dcapi_on_download(esp_http_client_event_t* evt) {
     return ESP_OK;
 }
 
-static esp_err_t dcapi_init_lazy(discord_handle_t client, bool download, const char* url) {
-    if(client->http != NULL)
-        return ESP_OK;
-
-    DISCORD_LOG_FOO();
-
-    if(client->state < DISCORD_STATE_CONNECTED) {
-        DISCORD_LOGW("API can be initialized only if client is in CONNECTED state");
-        return ESP_FAIL;
-    }
-
-    client->api_download_mode = download;
-
+/**
+ * @param oneshot Client without event handler (response is read directly), which does not depend on the api state
+ */
+static esp_http_client_handle_t dcapi_http_create_(discord_handle_t client, bool cdn, bool oneshot, const char* url) {
 #ifndef CONFIG_ESP_TLS_SKIP_SERVER_CERT_VERIFY
     extern const uint8_t api_crt[] asm("_binary_api_pem_start");
 #endif
 
     esp_http_client_config_t config = {
-        .url = download ? url : DISCORD_API_URL,
+        .url = url,
         .is_async = false,
-        .keep_alive_enable = !download,
-        .event_handler = download ? dcapi_on_download : dcapi_on_http_event,
+        .keep_alive_enable = true,
+        .event_handler = oneshot ? NULL : (cdn ? dcapi_on_download : dcapi_on_http_event),
         .user_data = client,
         .timeout_ms = client->config->api_timeout_ms,
 #ifndef CONFIG_ESP_TLS_SKIP_SERVER_CERT_VERIFY
@@ -154,36 +321,143 @@ static esp_err_t dcapi_init_lazy(discord_handle_t client, bool download, const c
 #endif
     };
 
-    client->api_buffer_record_status = ESP_OK;
+    esp_http_client_handle_t http = esp_http_client_init(&config);
 
-    if(!(client->api_lock = xSemaphoreCreateMutex()) ||
-       !(client->api_buffer = malloc(client->config->api_buffer_size)) ||
-       !(client->http = esp_http_client_init(&config))) {
-        DISCORD_LOGW("Cannot allocate api. No memory.");
-        dcapi_destroy(client);
-        return ESP_FAIL;
+    if(!http) {
+        return NULL;
     }
 
     char* user_agent = estr_cat("DiscordBot (esp-discord, " DISCORD_VER_STRING ") esp-idf/", esp_get_idf_version());
     // todo: memcheck
-    esp_http_client_set_header(client->http, "User-Agent", user_agent);
+    esp_http_client_set_header(http, "User-Agent", user_agent);
     // todo: error check
     free(user_agent);
     
-    if(!download) {
+    if(!cdn) {
         char* auth = estr_cat("Bot ", client->config->token);
         // todo: memcheck
-        esp_http_client_set_header(client->http, "Authorization", auth);
+        esp_http_client_set_header(http, "Authorization", auth);
         // todo: error check
         free(auth);
 
-        esp_http_client_set_header(client->http, "Content-Type", "multipart/form-data; boundary=\"" DCAPI_REQUEST_BOUNDARY "\"");
+        esp_http_client_set_header(http, "Content-Type", "multipart/form-data; boundary=\"" DCAPI_REQUEST_BOUNDARY "\"");
         // todo: error check
     }
 
+    return http;
+}
+
+static esp_http_client_handle_t dcapi_http_create(discord_handle_t client, bool cdn, const char* url) {
+    return dcapi_http_create_(client, cdn, false, url);
+}
+
+/**
+ * @brief Release api buffer and persistent clients. Api lock needs to be held (or not created)
+ */
+static void dcapi_release(discord_handle_t client) {
+    client->api_download_mode = false;
+    client->api_download_handler = NULL;
+    client->api_download_arg = NULL;
+    client->api_download_offset = 0;
+    client->api_download_total = 0;
+
+    if(client->api_buffer != NULL) {
+        free(client->api_buffer);
+        client->api_buffer = NULL;
+    }
+
+    client->api_buffer_size = 0;
+    client->api_buffer_record = false;
+
+    if(client->http) {
+        dcapi_flush_http(client, client->http, false);
+        esp_http_client_close(client->http);
+        esp_http_client_cleanup(client->http);
+        client->http = NULL;
+    }
+
+    if(client->cdn_http) {
+        esp_http_client_close(client->cdn_http);
+        esp_http_client_cleanup(client->cdn_http);
+        client->cdn_http = NULL;
+    }
+}
+
+/**
+ * @brief Initialize api buffer and persistent (keep-alive) client for api requests. Api lock needs to be held
+ */
+static esp_err_t dcapi_init_lazy(discord_handle_t client) {
+    if(client->http != NULL)
+        return ESP_OK;
+
+    DISCORD_LOG_FOO();
+
+    if(client->state < DISCORD_STATE_CONNECTED) {
+        DISCORD_LOGW("API can be initialized only if client is in CONNECTED state");
+        return ESP_FAIL;
+    }
+
+    client->api_buffer_record_status = ESP_OK;
+
+    if(!(client->api_buffer = malloc(client->config->api_buffer_size)) ||
+       !(client->http = dcapi_http_create(client, false, DISCORD_API_URL))) {
+        DISCORD_LOGW("Cannot allocate api. No memory.");
+        dcapi_release(client);
+        return ESP_FAIL;
+    }
+
     return ESP_OK;
 }
 
+/**
+ * @brief Take the api lock and make sure that api is initialized. Api can be destroyed (on disconnection) whenever the lock is not held
+ */
+static esp_err_t dcapi_lock_init(discord_handle_t client) {
+    if(xSemaphoreTake(client->api_lock, client->config->api_timeout_ms / portTICK_PERIOD_MS) != pdTRUE) {
+        DISCORD_LOGW("Api is locked");
+        return ESP_FAIL;
+    }
+
+    esp_err_t err;
+
+    if((err = dcapi_init_lazy(client)) != ESP_OK) { // will just return ESP_OK if already initialized
+        DISCORD_LOGW("Cannot initialize API");
+        xSemaphoreGive(client->api_lock);
+    }
+
+    return err;
+}
+
+/**
+ * @brief Take the api lock once the route is not rate limited. Fails if rate limit would not be reset before api timeout
+ */
+static esp_err_t dcapi_lock(discord_handle_t client, uint32_t route) {
+    uint64_t deadline = discord_tick_ms() + client->config->api_timeout_ms;
+    esp_err_t err;
+
+    while(true) {
+        if((err = dcapi_lock_init(client)) != ESP_OK) { // api could be destroyed while waiting for rate limit
+            return err;
+        }
+
+        uint32_t delay = dcapi_ratelimit_delay(client, route);
+
+        if(delay == 0) {
+            return ESP_OK;
+        }
+
+        xSemaphoreGive(client->api_lock); // allow requests of other routes while waiting
+
+        if(discord_tick_ms() + delay > deadline) {
+            DISCORD_LOGW("Rate limited for next %d ms", (int) delay);
+            return ESP_ERR_TIMEOUT;
+        }
+
+        DISCORD_LOGD("Rate limited, waiting %d ms...", (int) delay);
+        vTaskDelay(pdMS_TO_TICKS(delay));
+    }
+}
+
 static int dcapi_calculate_request_length(discord_api_request_t* request)
 {
     int length = 0;
@@ -224,23 +498,23 @@ esp_err_t dcapi_request(discord_handle_t client, esp_http_client_method_t method
     DISCORD_LOG_FOO();
 
     bool stream_response = out_response != NULL;
+    uint32_t route = dcapi_route_hash(method, request->uri);
 
     esp_err_t err;
 
-    if((err = dcapi_init_lazy(client, false, NULL)) != ESP_OK) { // will just return ESP_OK if already initialized
-        DISCORD_LOGW("Cannot initialize API");
+    if((err = dcapi_lock(client, route)) != ESP_OK) {
         return err;
     }
 
-    if(xSemaphoreTake(client->api_lock, client->config->api_timeout_ms / portTICK_PERIOD_MS) != pdTRUE) {
-        DISCORD_LOGW("Api is locked");
-        return ESP_FAIL;
-    }
-
     esp_http_client_handle_t http = client->http;
 
     client->api_buffer_record = true; // always record first chunk which comes with headers because maybe will need to record error
     client->api_buffer_record_status = ESP_OK;
+    client->api_ratelimit.remaining = client->api_ratelimit.reset_after_ms = client->api_ratelimit.retry_after_ms = -1;
+    client->api_ratelimit.global = false;
+    client->api_stream_handler = request->stream_handler;
+    client->api_stream_arg = request->stream_arg;
+    client->api_stream_status = ESP_OK;
 
     char* url = estr_cat(DISCORD_API_URL, request->uri);
     // todo: memcheck
@@ -335,7 +609,7 @@ esp_err_t dcapi_request(discord_handle_t client, esp_http_client_method_t method
 
     if(esp_http_client_fetch_headers(http) == ESP_FAIL) {
         DISCORD_LOGW("Fail to fetch headers");
-        dcapi_flush_http(client, false);
+        dcapi_flush_http(client, http, false);
         xSemaphoreGive(client->api_lock);
         return ESP_FAIL;
     }
@@ -344,9 +618,19 @@ esp_err_t dcapi_request(discord_handle_t client, esp_http_client_method_t method
         .code = esp_http_client_get_status_code(http)
     );
 
+    dcapi_ratelimit_update(client, route, res->code);
+
     bool is_error = ! dcapi_response_is_success(res);
 
-    dcapi_flush_http(client, stream_response || is_error);  // record if stream_response is true or there is errors
+    dcapi_flush_http(client, http, stream_response || is_error);  // record if stream_response is true or there is errors
+
+    if(client->api_stream_handler && ! is_error && client->api_stream_status != ESP_OK) {
+        DISCORD_LOGW("Fail to handle response stream");
+        err = client->api_stream_status;
+    }
+
+    client->api_stream_handler = NULL;
+    client->api_stream_arg = NULL;
 
     if(stream_response || is_error) {
         if(client->api_buffer_record_status != ESP_OK) {
@@ -383,46 +667,198 @@ esp_err_t dcapi_request(discord_handle_t client, esp_http_client_method_t method
     return err;
 }
 
+typedef struct {
+    esp_http_client_method_t method;
+    discord_api_request_t* request;
+    dcapi_callback_t callback;
+    void* arg;
+} dcapi_job_t;
+
+static void dcapi_job_finish(discord_handle_t client, dcapi_job_t* job, esp_err_t err, discord_api_response_t* res) {
+    discord_api_request_free(job->request);
+
+    if(job->callback) {
+        job->callback(client, err, res, job->arg);
+    }
+
+    if(res) {
+        dcapi_response_free(client, res);
+    }
+
+    free(job);
+}
+
+static void dcapi_worker_task(void* arg) {
+    discord_handle_t client = (discord_handle_t) arg;
+    dcapi_job_t* job = NULL;
+
+    DISCORD_LOG_FOO();
+
+    while(xQueueReceive(client->api_queue, &job, portMAX_DELAY) == pdPASS && job) { // NULL job stops the worker
+        discord_api_response_t* res = NULL;
+        esp_err_t err = dcapi_request(client, job->method, job->request, &res);
+        dcapi_job_finish(client, job, err, res);
+    }
+
+    xEventGroupSetBits(client->bits, DISCORD_API_STOPPED_BIT);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t dcapi_worker_create(discord_handle_t client) {
+    if(!client->api_queue && !(client->api_queue = xQueueCreate(DISCORD_DEFAULT_API_QUEUE_SIZE, sizeof(dcapi_job_t*)))) {
+        DISCORD_LOGW("Cannot create api queue. No memory.");
+        return ESP_ERR_NO_MEM;
+    }
+
+    xEventGroupClearBits(client->bits, DISCORD_API_STOPPED_BIT);
+
+    if(xTaskCreate(dcapi_worker_task, "discord_api_task", client->config->task_stack_size, client, client->config->task_priority, &client->api_task) != pdTRUE) {
+        DISCORD_LOGW("Cannot create api task");
+        client->api_task = NULL;
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Start api worker if it's not running. Worker is created under the api lock, so concurrent requests cannot create two workers
+ */
+static esp_err_t dcapi_worker_start(discord_handle_t client) {
+    if(client->api_task)
+        return ESP_OK;
+
+    DISCORD_LOG_FOO();
+
+    if(xSemaphoreTake(client->api_lock, client->config->api_timeout_ms / portTICK_PERIOD_MS) != pdTRUE) {
+        DISCORD_LOGW("Api is locked");
+        return ESP_FAIL;
+    }
+
+    // worker could be started by another task while waiting for the lock
+    esp_err_t err = client->api_task ? ESP_OK : dcapi_worker_create(client);
+    xSemaphoreGive(client->api_lock);
+
+    return err;
+}
+
+bool dcapi_is_worker(discord_handle_t client) {
+    return client->api_task && xTaskGetCurrentTaskHandle() == client->api_task;
+}
+
+void dcapi_worker_stop(discord_handle_t client) {
+    if(!client || !client->api_queue)
+        return;
+
+    DISCORD_LOG_FOO();
+
+    if(dcapi_is_worker(client)) { // it would wait for itself forever
+        DISCORD_LOGE("Cannot stop api worker from request callback");
+        return;
+    }
+
+    dcapi_job_t* job = NULL;
+
+    while(xQueueReceive(client->api_queue, &job, 0) == pdPASS) { // cancel pending requests
+        if(job) {
+            dcapi_job_finish(client, job, ESP_ERR_INVALID_STATE, NULL);
+        }
+    }
+
+    if(client->api_task) {
+        job = NULL;
+        xQueueSend(client->api_queue, &job, portMAX_DELAY);
+        xEventGroupWaitBits(client->bits, DISCORD_API_STOPPED_BIT, pdFALSE, pdTRUE, portMAX_DELAY); // wait for the request in progress
+        client->api_task = NULL;
+    }
+
+    vQueueDelete(client->api_queue);
+    client->api_queue = NULL;
+}
+
+esp_err_t dcapi_request_async(discord_handle_t client, esp_http_client_method_t method, discord_api_request_t* request, dcapi_callback_t callback, void* arg) {
+    if(!client || !request) {
+        discord_api_request_free(request);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(!client->running || client->state < DISCORD_STATE_CONNECTED) {
+        DISCORD_LOGW("Client is not connected");
+        discord_api_request_free(request);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err;
+
+    if((err = dcapi_worker_start(client)) != ESP_OK) {
+        discord_api_request_free(request);
+        return err;
+    }
+
+    dcapi_job_t* job = cu_ctor(dcapi_job_t,
+        .method = method,
+        .request = request,
+        .callback = callback,
+        .arg = arg
+    );
+
+    // todo: memcheck
+
+    if(xQueueSend(client->api_queue, &job, 0) != pdPASS) { // never block the caller (it may be an event handler)
+        DISCORD_LOGW("Api queue is full");
+        discord_api_request_free(request);
+        free(job);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
 esp_err_t dcapi_download(discord_handle_t client, const char* url, discord_download_handler_t download_handler, discord_api_response_t** out_response, void* arg) {
     if(! client || ! url ||  ! download_handler || ! out_response) {
         return ESP_ERR_INVALID_ARG;
     }
-    
-    if(client->api_download_mode && xSemaphoreTake(client->api_lock, client->config->api_timeout_ms / portTICK_PERIOD_MS) != pdTRUE) {
-        DISCORD_LOGW("Api is locked");
+
+    if(dcapi_lock_init(client) != ESP_OK) {
         return ESP_FAIL;
     }
 
-    dcapi_destroy(client); // destroy live http_client instance (if exist)
-
-    if(dcapi_init_lazy(client, true, url) != ESP_OK) { // create new instance for download
-        DISCORD_LOGW("Cannot initialize API");
+    if(!client->cdn_http && !(client->cdn_http = dcapi_http_create(client, true, url))) { // created once and kept alive for next downloads
+        DISCORD_LOGW("Cannot initialize CDN client");
+        xSemaphoreGive(client->api_lock);
         return ESP_FAIL;
     }
 
-    esp_http_client_handle_t http = client->http;
+    esp_http_client_handle_t http = client->cdn_http;
+    esp_http_client_set_url(http, url); // connection is reused if host is the same
+    // todo: error check
 
+    client->api_buffer_size = 0;
     client->api_buffer_record = true;
     client->api_buffer_record_status = ESP_OK;
+    client->api_download_mode = true;
     client->api_download_handler = download_handler;
     client->api_download_arg = arg;
+    client->api_download_offset = 0;
+    client->api_download_total = 0;
+
+    esp_err_t err = ESP_OK;
+    discord_api_response_t* res = NULL;
 
     if(esp_http_client_open(http, 0) != ESP_OK) {
         DISCORD_LOGW("Failed to open connection");
-        xSemaphoreGive(client->api_lock);
-        dcapi_destroy(client);
-        return ESP_FAIL;
+        err = ESP_FAIL;
+        goto _return;
     }
 
     if(esp_http_client_fetch_headers(http) == ESP_FAIL) {
         DISCORD_LOGW("Fail to fetch headers");
-        dcapi_flush_http(client, false);
-        xSemaphoreGive(client->api_lock);
-        dcapi_destroy(client);
-        return ESP_FAIL;
+        esp_http_client_close(http);
+        err = ESP_FAIL;
+        goto _return;
     }
 
-    discord_api_response_t* res = cu_ctor(discord_api_response_t,
+    res = cu_ctor(discord_api_response_t,
         .code = esp_http_client_get_status_code(http)
     );
 
@@ -435,17 +871,30 @@ esp_err_t dcapi_download(discord_handle_t client, const char* url, discord_downl
             client->api_download_total = esp_http_client_get_content_length(http);
         }
 
+        client->api_buffer_record = false;
+
         if(dcapi_download_handler_fire(client, client->api_buffer, client->api_buffer_size) == ESP_OK) {
-            dcapi_flush_http(client, false);
+            dcapi_flush_http(client, http, false);
+        } else {
+            esp_http_client_close(http); // user break chunk stream, rest of the response is not read
         }
+    } else {
+        client->api_download_mode = false; // do not pass error response to download handler
+        dcapi_flush_http(client, http, false);
     }
 
+_return:
+    client->api_buffer_size = 0;
     client->api_download_mode = false;
+    client->api_download_handler = NULL;
+    client->api_download_arg = NULL;
     xSemaphoreGive(client->api_lock);
-    dcapi_destroy(client); // destroy http_client, new one will be created on next request
 
-    *out_response = res;
-    return ESP_OK;
+    if(res) {
+        *out_response = res;
+    }
+
+    return err;
 }
 
 esp_err_t dcapi_add_multipart_to_request(discord_api_multipart_t* multipart, discord_api_request_t* request)
@@ -509,6 +958,110 @@ esp_err_t dcapi_get(discord_handle_t client, char* uri, char* payload, discord_a
     return err;
 }
 
+esp_err_t dcapi_get_oneshot(discord_handle_t client, const char* uri, char** out_data, int* out_len) {
+    if(!client || !uri || !out_data || !out_len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    DISCORD_LOG_FOO();
+
+    char* url = estr_cat(DISCORD_API_URL, uri);
+
+    if(!url) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_http_client_handle_t http = dcapi_http_create_(client, false, true, url);
+    free(url);
+
+    if(!http) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t size = client->config->api_buffer_size;
+    char* data = NULL;
+    int len = 0;
+    esp_err_t err = ESP_OK;
+
+    if(esp_http_client_open(http, 0) != ESP_OK || esp_http_client_fetch_headers(http) < 0) {
+        DISCORD_LOGW("Fail to fetch %s", uri);
+        err = ESP_FAIL;
+    } else if(esp_http_client_get_status_code(http) < 200 || esp_http_client_get_status_code(http) > 299) {
+        DISCORD_LOGW("Fail to fetch %s (code=%d)", uri, esp_http_client_get_status_code(http));
+        err = ESP_ERR_INVALID_RESPONSE;
+    } else if(!(data = malloc(size + 1))) {
+        err = ESP_ERR_NO_MEM;
+    } else {
+        int read;
+
+        while(len < size && (read = esp_http_client_read(http, data + len, size - len)) > 0) {
+            len += read;
+        }
+
+        if(len == size && esp_http_client_read(http, (char[1]) { 0 }, 1) > 0) { // there is more data
+            DISCORD_LOGW("Response of %s cannot fit into api buffer", uri);
+            err = ESP_ERR_INVALID_SIZE;
+        } else if(len <= 0) {
+            err = ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+
+    esp_http_client_close(http);
+    esp_http_client_cleanup(http);
+
+    if(err != ESP_OK) {
+        free(data);
+        return err;
+    }
+
+    data[len] = '\0';
+    *out_data = data;
+    *out_len = len;
+
+    return ESP_OK;
+}
+
+static esp_err_t dcapi_list_stream_handler(const char* data, size_t len, void* arg) {
+    return discord_list_decoder_feed((discord_list_decoder_handle_t) arg, data, len);
+}
+
+static esp_err_t dcapi_get_list_(discord_handle_t client, char* uri, const dcjs_schema_t* schema, discord_list_visitor_t visitor, void* arg, void*** out_list, int* out_len) {
+    discord_list_decoder_handle_t decoder = discord_list_decoder_create(schema, client->config->api_buffer_size, visitor, arg);
+
+    if(!decoder) {
+        free(uri);
+        return ESP_ERR_NO_MEM;
+    }
+
+    discord_api_request_t* request = dcapi_create_request(uri, NULL);
+    request->stream_handler = dcapi_list_stream_handler;
+    request->stream_arg = decoder;
+
+    discord_api_response_t* res = NULL;
+    esp_err_t err = dcapi_request(client, HTTP_METHOD_GET, request, &res);
+    discord_api_request_free(request);
+
+    if(err == ESP_OK) {
+        err = dcapi_response_is_success(res) ? discord_list_decoder_finish(decoder, out_list, out_len) : ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if(res) {
+        dcapi_response_free(client, res);
+    }
+
+    discord_list_decoder_destroy(decoder);
+
+    return err;
+}
+
+esp_err_t dcapi_get_list(discord_handle_t client, char* uri, const dcjs_schema_t* schema, void*** out_list, int* out_len) {
+    return dcapi_get_list_(client, uri, schema, NULL, NULL, out_list, out_len);
+}
+
+esp_err_t dcapi_foreach(discord_handle_t client, char* uri, const dcjs_schema_t* schema, discord_list_visitor_t visitor, void* arg) {
+    return dcapi_get_list_(client, uri, schema, visitor, arg, NULL, NULL);
+}
+
 esp_err_t dcapi_post(discord_handle_t client, char* uri, char* payload, discord_api_response_t** out_response) {
     discord_api_request_t* request = dcapi_create_request(uri, payload);
     esp_err_t err = dcapi_request(client, HTTP_METHOD_POST, request, out_response);
@@ -532,32 +1085,10 @@ esp_err_t dcapi_destroy(discord_handle_t client) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    if(client->api_lock) {
-        xSemaphoreTake(client->api_lock, portMAX_DELAY); // wait for unlock
-        vSemaphoreDelete(client->api_lock);
-        client->api_lock = NULL;
-    }
-
-    client->api_download_mode = false;
-    client->api_download_handler = NULL;
-    client->api_download_arg = NULL;
-    client->api_download_offset = 0;
-    client->api_download_total = 0;
-
-    if(client->api_buffer != NULL) {
-        free(client->api_buffer);
-        client->api_buffer = NULL;
-    }
-
-    client->api_buffer_size = 0;
-    client->api_buffer_record = false;
-
-    if(client->http) {
-        dcapi_flush_http(client, false);
-        esp_http_client_close(client->http);
-        esp_http_client_cleanup(client->http);
-        client->http = NULL;
-    }
+    // lock is not deleted, so requests which are waiting for it (or for rate limit) just find api destroyed
+    if(client->api_lock) { xSemaphoreTake(client->api_lock, portMAX_DELAY); } // wait for unlock
+    dcapi_release(client);
+    if(client->api_lock) { xSemaphoreGive(client->api_lock); }
 
     return ESP_OK;
 }
\ No newline at end of file
@@ -0,0 +1,386 @@
+#include "discord/private/_discord.h"
+#include "discord/private/_events.h"
+#include "discord/private/_gateway.h"
+#include "discord/message.h"
+#include "discord/message_reaction.h"
+#include "discord/voice_state.h"
+#include "freertos/event_groups.h"
+#include <string.h>
+
+DISCORD_LOG_DEFINE_BASE();
+
+/**
+ * @brief Get the key by which the event is assigned to the worker. Voice states are keyed by guild,
+ *        because channel is missing when user leaves the voice channel
+ * @return false if the event does not belong to any channel (and it's handled by discord task)
+ */
+static bool dcev_get_channel(discord_payload_t* payload, discord_snowflake_t* out_channel) {
+    if(!payload->d)
+        return false;
+
+    switch(payload->t) {
+        case DISCORD_EVENT_MESSAGE_RECEIVED:
+        case DISCORD_EVENT_MESSAGE_UPDATED:
+        case DISCORD_EVENT_MESSAGE_DELETED:
+            *out_channel = ((discord_message_t*) payload->d)->channel_id;
+            return true;
+
+        case DISCORD_EVENT_MESSAGE_REACTION_ADDED:
+        case DISCORD_EVENT_MESSAGE_REACTION_REMOVED:
+            *out_channel = ((discord_message_reaction_t*) payload->d)->channel_id;
+            return true;
+
+        case DISCORD_EVENT_VOICE_STATE_UPDATED:
+            *out_channel = ((discord_voice_state_t*) payload->d)->guild_id;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static esp_err_t dcev_dispatch_by(discord_handle_t client, discord_event_invocation_t* invocation, discord_event_t event, discord_event_data_ptr_t data_ptr);
+
+static void dcev_worker_task(void* arg) {
+    discord_event_worker_t* worker = (discord_event_worker_t*) arg;
+    discord_handle_t client = worker->client;
+    discord_payload_t* payload = NULL;
+
+    DISCORD_LOG_FOO();
+
+    while(xQueueReceive(worker->queue, &payload, portMAX_DELAY) == pdPASS && payload) { // NULL payload stops the worker
+        dcev_dispatch_by(client, &client->invocations[worker->index + 1], payload->t, payload->d);
+        discord_payload_free(payload);
+    }
+
+    xEventGroupSetBits(client->bits, DISCORD_WORKER_STOPPED_BIT(worker->index));
+    vTaskDelete(NULL);
+}
+
+static discord_event_handlers_t* dcev_get_handlers(discord_handle_t client, discord_event_t event) {
+    if(event == DISCORD_EVENT_ANY) {
+        return &client->any_handlers;
+    }
+
+    return event >= 0 && event < _DISCORD_EVENT_MAX ? &client->handlers[event] : NULL;
+}
+
+esp_err_t dcev_init(discord_handle_t client) {
+    uint8_t len = client->config->event_workers;
+
+    portMUX_INITIALIZE(&client->handlers_lock);
+
+    if(len == 0)
+        return ESP_OK;
+
+    if(len > DISCORD_EVENT_WORKERS_MAX) {
+        DISCORD_LOGE("Too many event workers (max %d)", DISCORD_EVENT_WORKERS_MAX);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    DISCORD_LOG_FOO();
+
+    if(!(client->workers = calloc(len, sizeof(discord_event_worker_t)))) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for(uint8_t i = 0; i < len; i++) {
+        discord_event_worker_t* worker = &client->workers[i];
+        worker->client = client;
+        worker->index = i;
+
+        if(!(worker->queue = xQueueCreate(DISCORD_EVENT_WORKER_QUEUE_SIZE, sizeof(discord_payload_t*)))) {
+            DISCORD_LOGE("Fail to create queue of the worker");
+            return ESP_FAIL;
+        }
+
+        xEventGroupClearBits(client->bits, DISCORD_WORKER_STOPPED_BIT(i));
+
+        if(xTaskCreate(dcev_worker_task, "discord_worker", client->config->task_stack_size, worker, client->config->task_priority, &worker->task) != pdTRUE) {
+            DISCORD_LOGE("Fail to create worker task");
+            worker->task = NULL;
+            return ESP_FAIL;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static void dcev_workers_destroy(discord_handle_t client) {
+    if(!client->workers)
+        return;
+
+    for(uint8_t i = 0; i < client->config->event_workers; i++) {
+        discord_event_worker_t* worker = &client->workers[i];
+
+        if(worker->task) {
+            discord_payload_t* payload = NULL;
+            xQueueSend(worker->queue, &payload, portMAX_DELAY);
+            xEventGroupWaitBits(client->bits, DISCORD_WORKER_STOPPED_BIT(i), pdFALSE, pdTRUE, portMAX_DELAY); // wait for the submitted events
+        }
+
+        if(worker->queue) {
+            vQueueDelete(worker->queue);
+        }
+    }
+
+    free(client->workers);
+    client->workers = NULL;
+}
+
+void dcev_destroy(discord_handle_t client) {
+    DISCORD_LOG_FOO();
+
+    dcev_workers_destroy(client);
+
+    for(int i = 0; i < _DISCORD_EVENT_MAX; i++) {
+        free(client->handlers[i].items);
+        client->handlers[i] = (discord_event_handlers_t) { 0 };
+    }
+
+    free(client->any_handlers.items);
+    client->any_handlers = (discord_event_handlers_t) { 0 };
+}
+
+bool dcev_is_worker(discord_handle_t client) {
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+
+    for(uint8_t i = 0; client->workers && i < client->config->event_workers; i++) {
+        if(client->workers[i].task == current) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Replace handlers array with the bigger copy, unless it's changed by another registration in the meantime
+ */
+static esp_err_t dcev_handlers_grow(discord_handle_t client, discord_event_handlers_t* handlers, discord_event_subscription_t* items, size_t capacity) {
+    size_t new_capacity = capacity > 0 ? capacity * 2 : DISCORD_EVENT_HANDLERS_INITIAL;
+    discord_event_subscription_t* new_items = malloc(new_capacity * sizeof(discord_event_subscription_t));
+
+    if(!new_items) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&client->handlers_lock);
+    if(handlers->items == items && handlers->capacity == capacity) {
+        memcpy(new_items, items, handlers->len * sizeof(discord_event_subscription_t));
+        handlers->items = new_items;
+        handlers->capacity = new_capacity;
+        new_items = items; // free the old one
+    }
+    portEXIT_CRITICAL(&client->handlers_lock);
+
+    free(new_items);
+
+    return ESP_OK;
+}
+
+esp_err_t dcev_register(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler, void* event_handler_arg) {
+    discord_event_handlers_t* handlers = dcev_get_handlers(client, event);
+    esp_err_t err = ESP_OK;
+
+    if(!handlers || !event_handler) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    while(err == ESP_OK) {
+        discord_event_subscription_t* items = NULL;
+        size_t capacity = 0;
+        bool done = true;
+
+        portENTER_CRITICAL(&client->handlers_lock);
+        size_t i = 0;
+
+        while(i < handlers->len && handlers->items[i].handler != event_handler) {
+            i++;
+        }
+
+        if(i < handlers->len) {
+            handlers->items[i].arg = event_handler_arg;
+        } else if(handlers->len < handlers->capacity) {
+            handlers->items[handlers->len++] = (discord_event_subscription_t) { .handler = event_handler, .arg = event_handler_arg };
+        } else { // memory cannot be allocated in critical section
+            items = handlers->items;
+            capacity = handlers->capacity;
+            done = false;
+        }
+        portEXIT_CRITICAL(&client->handlers_lock);
+
+        if(done)
+            break;
+
+        err = dcev_handlers_grow(client, handlers, items, capacity);
+    }
+
+    return err;
+}
+
+/**
+ * @brief Check whether the handler is invoked by another task. Handler which unregisters a handler does not wait
+ *        for other tasks, because they could wait for it as well
+ */
+static bool dcev_is_invoked(discord_handle_t client, esp_event_handler_t event_handler) {
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    bool invoked = false;
+
+    portENTER_CRITICAL(&client->handlers_lock);
+    for(size_t i = 0; i < sizeof(client->invocations) / sizeof(client->invocations[0]); i++) {
+        discord_event_invocation_t* invocation = &client->invocations[i];
+
+        if(invocation->handler && invocation->task == current) {
+            invoked = false;
+            break;
+        }
+
+        if(invocation->handler == event_handler) {
+            invoked = true;
+        }
+    }
+    portEXIT_CRITICAL(&client->handlers_lock);
+
+    return invoked;
+}
+
+esp_err_t dcev_unregister(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler) {
+    discord_event_handlers_t* handlers = dcev_get_handlers(client, event);
+
+    if(!handlers) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&client->handlers_lock);
+    for(size_t i = 0; i < handlers->len; i++) {
+        if(handlers->items[i].handler == event_handler) { // shift the rest to keep the order of registration
+            memmove(&handlers->items[i], &handlers->items[i + 1], (handlers->len - i - 1) * sizeof(discord_event_subscription_t));
+            handlers->len--;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&client->handlers_lock);
+
+    // handler is not invoked anymore once it returns, so the caller can free its argument
+    while(dcev_is_invoked(client, event_handler)) {
+        vTaskDelay(1);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Find the handler in the current handlers and mark it as invoked by the task
+ * @return false if handler is unregistered in the meantime
+ */
+static bool dcev_invocation_begin(discord_handle_t client, discord_event_invocation_t* invocation, discord_event_handlers_t* handlers, discord_event_subscription_t* subscription) {
+    bool registered = false;
+
+    portENTER_CRITICAL(&client->handlers_lock);
+    for(size_t i = 0; i < handlers->len; i++) {
+        if(handlers->items[i].handler == subscription->handler) {
+            subscription->arg = handlers->items[i].arg; // argument may be updated by the registration in the meantime
+            invocation->handler = subscription->handler;
+            registered = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&client->handlers_lock);
+
+    return registered;
+}
+
+static void dcev_invocation_end(discord_handle_t client, discord_event_invocation_t* invocation) {
+    portENTER_CRITICAL(&client->handlers_lock);
+    invocation->handler = NULL;
+    portEXIT_CRITICAL(&client->handlers_lock);
+}
+
+esp_err_t dcev_dispatch(discord_handle_t client, discord_event_t event, discord_event_data_ptr_t data_ptr) {
+    return dcev_dispatch_by(client, &client->invocations[0], event, data_ptr);
+}
+
+static esp_err_t dcev_dispatch_by(discord_handle_t client, discord_event_invocation_t* invocation, discord_event_t event, discord_event_data_ptr_t data_ptr) {
+    discord_event_handlers_t* handlers = dcev_get_handlers(client, event);
+    size_t any_len = 0;
+    discord_event_subscription_t buffer[DISCORD_EVENT_HANDLERS_INITIAL * 2];
+    discord_event_subscription_t* subscriptions = buffer;
+    size_t capacity = DISCORD_EVENT_HANDLERS_INITIAL * 2;
+    size_t len = 0;
+
+    if(!handlers || event == DISCORD_EVENT_ANY) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // take a snapshot, so handlers can be (un)registered while they are invoked, even by the handler itself
+    while(true) {
+        portENTER_CRITICAL(&client->handlers_lock);
+        any_len = client->any_handlers.len;
+        len = any_len + handlers->len;
+
+        if(len <= capacity) {
+            memcpy(subscriptions, client->any_handlers.items, client->any_handlers.len * sizeof(discord_event_subscription_t));
+            memcpy(subscriptions + client->any_handlers.len, handlers->items, handlers->len * sizeof(discord_event_subscription_t));
+        }
+        portEXIT_CRITICAL(&client->handlers_lock);
+
+        if(len <= capacity)
+            break;
+
+        // more handlers than fits on the stack. Allocate the snapshot and take it again
+        if(subscriptions != buffer) {
+            free(subscriptions);
+        }
+
+        if(!(subscriptions = malloc(len * sizeof(discord_event_subscription_t)))) {
+            DISCORD_LOGE("Fail to allocate handlers of event %d", event);
+            return ESP_ERR_NO_MEM;
+        }
+
+        capacity = len;
+    }
+
+    discord_event_data_t event_data = {
+        .client = client,
+        .shard_id = client->config->shard_id,
+        .ptr = data_ptr
+    };
+
+    invocation->task = xTaskGetCurrentTaskHandle();
+
+    for(size_t i = 0; i < len; i++) {
+        if(!dcev_invocation_begin(client, invocation, i < any_len ? &client->any_handlers : handlers, &subscriptions[i])) {
+            continue; // unregistered by the previous handler or by another task
+        }
+
+        subscriptions[i].handler(subscriptions[i].arg, DISCORD_EVENTS, event, &event_data);
+        dcev_invocation_end(client, invocation);
+    }
+
+    if(subscriptions != buffer) {
+        free(subscriptions);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t dcev_submit(discord_handle_t client, discord_payload_t* payload) {
+    discord_snowflake_t channel = DISCORD_SNOWFLAKE_NULL;
+
+    if(!client->workers || !dcev_get_channel(payload, &channel)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // mix the timestamp into the low bits, which are mostly the same for all of the snowflakes
+    discord_event_worker_t* worker = &client->workers[(uint32_t) (channel ^ (channel >> 22)) % client->config->event_workers];
+
+    // never block discord task, it would stall heartbeats and events of the other workers
+    if(xQueueSend(worker->queue, &payload, 0) != pdPASS) {
+        DISCORD_LOGD("Worker %d is busy", worker->index);
+        dcgw_drop_payload(client, payload);
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
\ No newline at end of file
@@ -1,31 +1,98 @@
 #include "discord/private/_gateway.h"
 #include "discord/private/_json.h"
+#include "discord/private/_api.h"
+#include "discord/private/_events.h"
 #include "discord/message.h"
 #include "esp_transport_ws.h"
+#include "nvs.h"
+#include "esp_heap_caps.h"
+#include <time.h>
 #include "cutils.h"
 #include "estr.h"
+#if __has_include("esp_random.h")
+#include "esp_random.h"
+#else
+#include "esp_system.h"
+#endif
+
+#if __has_include("miniz.h")
+#include "miniz.h"
+#elif __has_include("rom/miniz.h")
+#include "rom/miniz.h"
+#else
+#include "esp32/rom/miniz.h"
+#endif
+
+#define DCGW_ZLIB_SUFFIX 0x0000FFFF
+#define DCGW_CLOSE_BUFFER_SIZE 125  /*<! Maximum payload of the control frame */
+#define DCGW_DROP_REPORT_INTERVAL_MS 1000  /*<! Dropped payloads are reported at most once per interval */
+#define DCGW_WALL_CLOCK_MIN 1600000000  /*<! Wall clock before this time (Sep 2020) is considered as not set */
+
+/**
+ * @brief GET /gateway/bot response cached in NVS
+ */
+typedef struct {
+    uint32_t token_hash;               /*<! Cached info belongs to the bot with this token */
+    char url[DISCORD_GW_INFO_URL_SIZE];
+    uint16_t shards;
+    uint8_t max_concurrency;
+    uint32_t remaining;
+    int64_t reset_at;                  /*<! Unix time when remaining number is reset. 0 if wall clock was not set */
+    int64_t expires_at;                /*<! Unix time when record expires. 0 if wall clock was not set */
+} dcgw_info_record_t;
 
 DISCORD_LOG_DEFINE_BASE();
 
+static portMUX_TYPE dcgw_identify_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t dcgw_identify_next_ms[DISCORD_GW_IDENTIFY_KEYS];  /*<! Time from which the next identify is allowed, per rate limit key. Shared by all clients */
+
+/**
+ * @brief Persistent inflate context of zlib-stream transport compression.
+ *        Whole connection is one zlib stream so context lives until the connection is closed
+ */
+struct discord_gw_inflater {
+    tinfl_decompressor decompressor;
+    uint8_t dict[TINFL_LZ_DICT_SIZE];  /*<! Sliding window (circular) which is used as output buffer as well */
+    size_t dict_offset;
+    uint32_t tail;                     /*<! Last 4 received compressed bytes, used for Z_SYNC_FLUSH suffix detection */
+};
+
 static void dcgw_heartbeat_stop(discord_handle_t client) {
     DISCORD_LOG_FOO();
 
+    if(client->heartbeater.running) {
+        esp_timer_stop(client->heartbeater.timer);
+    }
+
     client->heartbeater.running = false;
     client->heartbeater.interval = 0;
     client->heartbeater.tick_ms = 0;
     client->heartbeater.received_ack = false;
 }
 
+/**
+ * @brief Check whether the data of the dispatch event is needed. READY and RESUMED are handled internally
+ */
+static bool dcgw_dispatch_event_is_required(discord_event_t event, void* arg) {
+    discord_handle_t client = (discord_handle_t) arg;
+
+    return event == DISCORD_EVENT_READY || event == DISCORD_EVENT_RESUMED || DISCORD_EVENT_HAS_SUBSCRIBERS(event);
+}
+
 static bool dcgw_whether_payload_should_go_into_queue(discord_handle_t client, discord_payload_t* payload) {
     if(!payload)
         return false;
 
     if(payload->op == DISCORD_OP_DISPATCH) {
-        if(client->state < DISCORD_STATE_CONNECTED && payload->t != DISCORD_EVENT_READY) {
-            DISCORD_LOGW("Ignoring payload because client is not in CONNECTED state and still not receive READY payload");
+        if(!client->session && payload->t != DISCORD_EVENT_READY) {
+            DISCORD_LOGW("Ignoring payload because client does not have a session and still not receive READY payload");
             return false;
         }
 
+        if(!dcgw_dispatch_event_is_required(payload->t, client)) {
+            return false; // nobody is interested in this event
+        }
+
         switch(payload->t) {
             case DISCORD_EVENT_MESSAGE_RECEIVED:
             case DISCORD_EVENT_MESSAGE_UPDATED: {
@@ -34,7 +101,7 @@ static bool dcgw_whether_payload_should_go_into_queue(discord_handle_t client, d
                     if(!msg ||
                         !msg->author ||
                         !(msg->type == DISCORD_MESSAGE_DEFAULT || msg->type == DISCORD_MESSAGE_REPLY) || // ignore if not default or reply type
-                        estr_eq(msg->author->id, client->session->user->id)) { // ignore our messages
+                        msg->author->id == client->session->user->id) { // ignore our messages
                         return false;
                     }
                 }
@@ -45,7 +112,7 @@ static bool dcgw_whether_payload_should_go_into_queue(discord_handle_t client, d
                     discord_message_reaction_t* react = (discord_message_reaction_t*) payload->d;
 
                     // ignore our reactions
-                    if(!react || !react->emoji || estr_eq(react->user_id, client->session->user->id)) {
+                    if(!react || !react->emoji || !react->emoji->name || react->user_id == client->session->user->id) {
                         return false;
                     }
                 }
@@ -68,57 +135,479 @@ static discord_close_code_t dcgw_get_close_opcode(discord_handle_t client) {
     return DISCORD_CLOSEOP_NO_CODE;
 }
 
-static esp_err_t dcgw_buffer_websocket_data(discord_handle_t client, esp_websocket_event_data_t* data) {
-    DISCORD_LOG_FOO();
+void dcgw_drop_payload(discord_handle_t client, discord_payload_t* payload) {
+    discord_event_t event = payload->op == DISCORD_OP_DISPATCH ? payload->t : DISCORD_EVENT_UNKNOWN;
+    uint64_t now = discord_tick_ms();
+    uint32_t unreported = 0;
+
+    DISCORD_LOGD("Event %d is dropped", event);
+
+    portENTER_CRITICAL(&client->dropped.lock);
+    if(event >= 0 && event < _DISCORD_EVENT_MAX) {
+        client->dropped.count[event]++;
+    }
+
+    client->dropped.unreported++;
+
+    if(client->dropped.reported_ms == 0 || now - client->dropped.reported_ms >= DCGW_DROP_REPORT_INTERVAL_MS) {
+        unreported = client->dropped.unreported;
+        client->dropped.unreported = 0;
+        client->dropped.reported_ms = now;
+    }
+    portEXIT_CRITICAL(&client->dropped.lock);
+
+    if(unreported > 0) { // warn once per burst, not for every dropped payload
+        DISCORD_LOGW("Queue is full, %d event(s) dropped", (int) unreported);
+    }
+
+    discord_payload_free(payload);
+}
+
+static bool dcgw_overflow_push(discord_handle_t client, discord_payload_t* payload) {
+    discord_gw_overflow_t* overflow = &client->overflow;
+    discord_payload_t* dropped = NULL;
+
+    if(!overflow->items) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&overflow->lock);
+    if(overflow->len == overflow->size) { // drop the oldest one
+        dropped = overflow->items[overflow->head];
+        overflow->head = (overflow->head + 1) % overflow->size;
+        overflow->len--;
+    }
+
+    overflow->items[(overflow->head + overflow->len) % overflow->size] = payload;
+    overflow->len++;
+    portEXIT_CRITICAL(&overflow->lock);
+
+    if(dropped) {
+        dcgw_drop_payload(client, dropped);
+    }
+
+    return true;
+}
+
+static discord_payload_t* dcgw_overflow_pop(discord_handle_t client) {
+    discord_gw_overflow_t* overflow = &client->overflow;
+    discord_payload_t* payload = NULL;
+
+    if(!overflow->items) {
+        return NULL;
+    }
+
+    portENTER_CRITICAL(&overflow->lock);
+    if(overflow->len > 0) {
+        payload = overflow->items[overflow->head];
+        overflow->head = (overflow->head + 1) % overflow->size;
+        overflow->len--;
+    }
+    portEXIT_CRITICAL(&overflow->lock);
+
+    return payload;
+}
+
+/**
+ * @brief Replace queued MESSAGE_UPDATED of the same message by the new one. Queue is drained and refilled
+ *        in the same order, discord task does not take payloads in the meantime
+ * @return true if payload is coalesced
+ */
+static bool dcgw_queue_coalesce(discord_handle_t client, discord_payload_t* payload) {
+    if(payload->op != DISCORD_OP_DISPATCH || payload->t != DISCORD_EVENT_MESSAGE_UPDATED || !payload->d) {
+        return false;
+    }
+
+    discord_snowflake_t id = ((discord_message_t*) payload->d)->id;
+    discord_payload_t** items = client->coalesce.items;
+    bool coalesced = false;
+    int len = 0;
+
+    xSemaphoreTake(client->coalesce.lock, portMAX_DELAY);
+
+    while(len < client->config->queue_size && xQueueReceive(client->queue, &items[len], 0) == pdPASS) {
+        len++;
+    }
+
+    for(int i = 0; i < len; i++) {
+        discord_payload_t* item = items[i];
+
+        if(!coalesced && item->op == DISCORD_OP_DISPATCH && item->t == DISCORD_EVENT_MESSAGE_UPDATED
+            && item->d && ((discord_message_t*) item->d)->id == id) {
+            DISCORD_LOGD("Update of message %" DISCORD_SNOWFLAKE_FMT " is coalesced", id);
+            discord_payload_free(item);
+            item = payload;
+            coalesced = true;
+        }
+
+        xQueueSend(client->queue, &item, 0);
+    }
+
+    xSemaphoreGive(client->coalesce.lock);
+
+    return coalesced;
+}
+
+/**
+ * @brief Put payload into the queue without blocking. HELLO and HEARTBEAT_ACK go into the control queue,
+ *        other payloads are handled by queue policy if the queue is full. RECONNECT and INVALID_SESSION
+ *        stay in order with dispatches, because they close the connection and dispatches received before them
+ *        (whose sequence numbers are already taken) would be flushed otherwise
+ */
+static void dcgw_queue_put(discord_handle_t client, discord_payload_t* payload) {
+    discord_queue_policy_t policy = client->config->queue_policy;
+    bool control = payload->op != DISCORD_OP_DISPATCH; // control payloads are never dropped
+
+    if(payload->op == DISCORD_OP_HELLO || payload->op == DISCORD_OP_HEARTBEAT_ACK) {
+        if(xQueueSend(client->control_queue, &payload, 0) != pdPASS) { // should not happen, gateway sends only few control payloads per connection
+            DISCORD_LOGE("Control queue is full, payload (op: %d) is dropped", payload->op);
+            discord_payload_free(payload);
+        }
+
+        return;
+    }
+
+    if(policy == DISCORD_QUEUE_SPILL && client->overflow.len > 0 && dcgw_overflow_push(client, payload)) {
+        return; // ring is not empty, so payload needs to go after the payloads in the ring
+    }
+
+    if(xQueueSend(client->queue, &payload, 0) == pdPASS) {
+        return;
+    }
+
+    if(policy == DISCORD_QUEUE_SPILL && dcgw_overflow_push(client, payload)) {
+        return;
+    }
+
+    if(policy == DISCORD_QUEUE_COALESCE && dcgw_queue_coalesce(client, payload)) {
+        return;
+    }
+
+    if(policy == DISCORD_QUEUE_DROP_NEWEST && !control) {
+        dcgw_drop_payload(client, payload);
+        return;
+    }
+
+    discord_payload_t* oldest = NULL;
+
+    while(xQueueSend(client->queue, &payload, 0) != pdPASS) {
+        if(xQueueReceive(client->queue, &oldest, 0) == pdPASS) {
+            dcgw_drop_payload(client, oldest);
+        }
+    }
+}
 
-    if(data->payload_len > client->config->gateway_buffer_size) {
-        DISCORD_LOGW("Payload too big. Wider buffer required.");
+bool dcgw_queue_receive(discord_handle_t client, discord_payload_t** out_payload) {
+    if(xQueueReceive(client->control_queue, out_payload, 0) == pdPASS) {
+        return true;
+    }
+
+    if(client->coalesce.lock) { xSemaphoreTake(client->coalesce.lock, portMAX_DELAY); } // wait until the queue is refilled
+    bool received = xQueueReceive(client->queue, out_payload, 0) == pdPASS;
+    if(client->coalesce.lock) { xSemaphoreGive(client->coalesce.lock); }
+
+    if(received) {
+        return true;
+    }
+
+    return (*out_payload = dcgw_overflow_pop(client)) != NULL;
+}
+
+/**
+ * @brief Take the payload which is fed into decoder and put it into the queue
+ */
+static esp_err_t dcgw_handle_decoded_payload(discord_handle_t client) {
+    discord_payload_t* payload = discord_payload_decoder_finish(client->gw_decoder);
+
+    if(!payload) {
+        DISCORD_LOGE("Fail to deserialize payload");
         return ESP_FAIL;
     }
+
+    if(payload->s != DISCORD_NULL_SEQUENCE_NUMBER) {
+        client->last_sequence_number = payload->s;
+    }
+
+    if(payload->op == DISCORD_OP_HEARTBEAT_ACK) {
+        client->heartbeater.ack_tick_ms = discord_tick_ms();
+    }
     
-    DISCORD_LOGD("Buffering received data:\n%.*s", data->data_len, data->data_ptr);
-    
+    if(! dcgw_whether_payload_should_go_into_queue(client, payload)) {
+        DISCORD_LOGD("Payload ignored");
+        discord_payload_free(payload);
+    } else {
+        dcgw_queue_put(client, payload);
+        DISCORD_NOTIFY(DISCORD_NOTIFY_PAYLOAD);
+    }
+
+    return ESP_OK;
+}
+
+static void dcgw_inflater_reset(discord_handle_t client) {
+    struct discord_gw_inflater* inflater = client->gw_inflater;
+
+    if(!inflater)
+        return;
+
+    tinfl_init(&inflater->decompressor);
+    inflater->dict_offset = 0;
+    inflater->tail = 0;
+}
+
+/**
+ * @brief Inflate chunk of zlib-stream and feed decompressed data to the payload decoder.
+ *        Payload is handled once when Z_SYNC_FLUSH suffix is received at the end of frame
+ */
+static esp_err_t dcgw_inflate_data(discord_handle_t client, const char* data, size_t len, bool last) {
+    struct discord_gw_inflater* inflater = client->gw_inflater;
+
+    if(!inflater) {
+        DISCORD_LOGW("Compressed data received but compression is not enabled");
+        return ESP_FAIL;
+    }
+
+    const uint8_t* in = (const uint8_t*) data;
+    size_t in_left = len;
+
+    for(int i = len > 4 ? len - 4 : 0; i < len; i++) {
+        inflater->tail = (inflater->tail << 8) | in[i];
+    }
+
+    tinfl_status status;
+
+    do {
+        size_t in_bytes = in_left;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - inflater->dict_offset;
+        uint8_t* out = inflater->dict + inflater->dict_offset;
+
+        status = tinfl_decompress(
+            &inflater->decompressor, in, &in_bytes,
+            inflater->dict, out, &out_bytes,
+            TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT
+        );
+
+        if(status < TINFL_STATUS_DONE) {
+            DISCORD_LOGE("Fail to inflate data (status=%d)", status);
+            client->state = DISCORD_STATE_ERROR; // stream is corrupted, reconnection is required
+            return ESP_FAIL;
+        }
+
+        in += in_bytes;
+        in_left -= in_bytes;
+
+        if(out_bytes > 0) {
+            DISCORD_LOGD("Inflated data:\n%.*s", out_bytes, (const char*) out);
+            // decoder keeps the error until the end of payload, and the inflating needs to continue anyway
+            // in order to preserve the stream context
+            discord_payload_decoder_feed(client->gw_decoder, (const char*) out, out_bytes);
+            inflater->dict_offset = (inflater->dict_offset + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+        }
+
+        if(in_bytes == 0 && out_bytes == 0) { // no progress
+            break;
+        }
+    } while(in_left > 0 || status == TINFL_STATUS_HAS_MORE_OUTPUT);
+
+    if(!last || inflater->tail != DCGW_ZLIB_SUFFIX) {
+        return ESP_OK; // wait for the rest of the message
+    }
+
+    return dcgw_handle_decoded_payload(client);
+}
+
+static esp_err_t dcgw_buffer_close_frame(discord_handle_t client, esp_websocket_event_data_t* data) {
+    if(data->payload_offset + data->data_len > DCGW_CLOSE_BUFFER_SIZE) {
+        DISCORD_LOGW("Invalid close frame");
+        return ESP_FAIL;
+    }
+
     memcpy(client->gw_buffer + data->payload_offset, data->data_ptr, data->data_len);
 
     if((client->gw_buffer_len = data->data_len + data->payload_offset) >= data->payload_len) {
-        DISCORD_LOGD("Buffering done");
-
         // append null terminator
         client->gw_buffer[client->gw_buffer_len] = '\0';
+        client->state = DISCORD_STATE_DISCONNECTING;
+        client->close_code = dcgw_get_close_opcode(client);
+    }
 
-        if(data->op_code == WS_TRANSPORT_OPCODES_CLOSE) {
-            client->state = DISCORD_STATE_DISCONNECTING;
-            client->close_code = dcgw_get_close_opcode(client);
+    return ESP_OK;
+}
 
-            return ESP_OK;
-        }
+/**
+ * @brief Feed received fragment of the frame directly to the payload decoder (without reassembling the frame)
+ */
+static esp_err_t dcgw_decode_data(discord_handle_t client, uint8_t op_code, const char* data, size_t len, bool first, bool last) {
+    if(op_code == WS_TRANSPORT_OPCODES_BINARY) {
+        return dcgw_inflate_data(client, data, len, last);
+    }
+    
+    DISCORD_LOGD("Received data:\n%.*s", len, data);
+
+    if(first) { // beginning of the new payload
+        discord_payload_decoder_reset(client->gw_decoder);
+    }
 
-        discord_payload_t* payload = discord_json_deserialize_(payload, client->gw_buffer, client->gw_buffer_len);
+    discord_payload_decoder_feed(client->gw_decoder, data, len);
 
-        if(!payload) {
-            DISCORD_LOGE("Fail to deserialize payload");
-            return ESP_FAIL;
-        }
+    if(last) {
+        DISCORD_LOGD("Receiving done");
+        return dcgw_handle_decoded_payload(client);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Copy received fragment of the frame into the chunks from the pool and pass them to decode task.
+ *        Waits for the free chunk at most DISCORD_GW_DECODE_TIMEOUT_MS. Part of the frame cannot be skipped
+ *        without corrupting the stream, so if the decode task does not keep up, client reconnects
+ */
+static esp_err_t dcgw_decode_push(discord_handle_t client, esp_websocket_event_data_t* data) {
+    discord_gw_decode_t* decode = &client->gw_decode;
+    int offset = 0;
+
+    if(client->state == DISCORD_STATE_ERROR) { // stream is already corrupted, ignore the rest until reconnection
+        return ESP_FAIL;
+    }
+
+    do {
+        discord_gw_chunk_t* chunk = NULL;
 
-        if(payload->s != DISCORD_NULL_SEQUENCE_NUMBER) {
-            client->last_sequence_number = payload->s;
+        if(xQueueReceive(decode->pool, &chunk, DISCORD_GW_DECODE_TIMEOUT_MS / portTICK_PERIOD_MS) != pdPASS) {
+            DISCORD_LOGE("Decode task is stuck. Reconnecting...");
+            client->state = DISCORD_STATE_ERROR; // stream is corrupted, reconnection is required
+            return ESP_ERR_TIMEOUT;
         }
-        
-        if(! dcgw_whether_payload_should_go_into_queue(client, payload)) {
-            DISCORD_LOGD("Payload ignored");
-            discord_payload_free(payload);
-        } else if(xQueueSend(client->queue, &payload, 5000 / portTICK_PERIOD_MS) != pdPASS) { // 5sec timeout
-            DISCORD_LOGW("Fail to queue the payload");
-            discord_payload_free(payload);
+
+        chunk->op_code = data->op_code;
+        chunk->len = data->data_len - offset > DISCORD_GW_WS_BUFFER_SIZE ? DISCORD_GW_WS_BUFFER_SIZE : data->data_len - offset;
+        chunk->first = data->payload_offset == 0 && offset == 0;
+        chunk->last = offset + chunk->len == data->data_len && data->payload_offset + data->data_len >= data->payload_len;
+        memcpy(chunk->data, data->data_ptr + offset, chunk->len);
+        offset += chunk->len;
+
+        xQueueSend(decode->chunks, &chunk, 0); // never full, it has room for every chunk of the pool
+    } while(offset < data->data_len);
+
+    return ESP_OK;
+}
+
+static esp_err_t dcgw_handle_websocket_data(discord_handle_t client, esp_websocket_event_data_t* data) {
+    DISCORD_LOG_FOO();
+
+    if(data->op_code == WS_TRANSPORT_OPCODES_CLOSE) {
+        return dcgw_buffer_close_frame(client, data);
+    }
+
+    if(client->gw_decode.task) {
+        return dcgw_decode_push(client, data);
+    }
+
+    return dcgw_decode_data(client, data->op_code, data->data_ptr, data->data_len,
+        data->payload_offset == 0,
+        data->payload_offset + data->data_len >= data->payload_len
+    );
+}
+
+static void dcgw_decode_task(void* arg) {
+    discord_handle_t client = (discord_handle_t) arg;
+    discord_gw_decode_t* decode = &client->gw_decode;
+    discord_gw_chunk_t* chunk = NULL;
+
+    DISCORD_LOG_FOO();
+
+    while(xQueueReceive(decode->chunks, &chunk, portMAX_DELAY) == pdPASS && chunk) { // NULL chunk stops the task
+        discord_gateway_state_t state = client->state;
+        dcgw_decode_data(client, chunk->op_code, chunk->data, chunk->len, chunk->first, chunk->last);
+        xQueueSend(decode->pool, &chunk, portMAX_DELAY);
+
+        if(client->state != state) { // inflating failed
+            DISCORD_NOTIFY(DISCORD_NOTIFY_STATE);
         }
     }
 
+    xEventGroupSetBits(client->bits, DISCORD_GW_DECODE_STOPPED_BIT);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Wait until all of the received chunks are decoded (every chunk is back in the pool)
+ */
+static void dcgw_decode_drain(discord_handle_t client) {
+    discord_gw_decode_t* decode = &client->gw_decode;
+    discord_gw_chunk_t* chunks[DISCORD_GW_DECODE_CHUNKS];
+
+    if(!decode->task)
+        return;
+
+    for(int i = 0; i < DISCORD_GW_DECODE_CHUNKS; i++) {
+        xQueueReceive(decode->pool, &chunks[i], portMAX_DELAY);
+    }
+
+    for(int i = 0; i < DISCORD_GW_DECODE_CHUNKS; i++) {
+        xQueueSend(decode->pool, &chunks[i], 0);
+    }
+}
+
+static esp_err_t dcgw_decode_start(discord_handle_t client) {
+    discord_gw_decode_t* decode = &client->gw_decode;
+    BaseType_t core = tskNO_AFFINITY;
+
+    if(!(decode->pool = xQueueCreate(DISCORD_GW_DECODE_CHUNKS, sizeof(discord_gw_chunk_t*))) ||
+       !(decode->chunks = xQueueCreate(DISCORD_GW_DECODE_CHUNKS + 1, sizeof(discord_gw_chunk_t*))) || // +1 for stopping NULL chunk
+       !(decode->buffers = malloc(DISCORD_GW_DECODE_CHUNKS * sizeof(discord_gw_chunk_t)))) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for(int i = 0; i < DISCORD_GW_DECODE_CHUNKS; i++) {
+        discord_gw_chunk_t* chunk = &decode->buffers[i];
+        xQueueSend(decode->pool, &chunk, 0);
+    }
+
+    if(client->config->gateway_decode == DISCORD_GW_DECODE_TASK_CORE_0) {
+        core = 0;
+    } else if(client->config->gateway_decode == DISCORD_GW_DECODE_TASK_CORE_1 && portNUM_PROCESSORS > 1) {
+        core = 1;
+    }
+
+    xEventGroupClearBits(client->bits, DISCORD_GW_DECODE_STOPPED_BIT);
+
+    if(xTaskCreatePinnedToCore(dcgw_decode_task, "discord_decode_task", client->config->task_stack_size, client, client->config->task_priority, &decode->task, core) != pdTRUE) {
+        decode->task = NULL;
+        return ESP_FAIL;
+    }
+
     return ESP_OK;
 }
 
+static void dcgw_decode_stop(discord_handle_t client) {
+    discord_gw_decode_t* decode = &client->gw_decode;
+
+    if(decode->task) {
+        discord_gw_chunk_t* chunk = NULL;
+        xQueueSend(decode->chunks, &chunk, portMAX_DELAY);
+        xEventGroupWaitBits(client->bits, DISCORD_GW_DECODE_STOPPED_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+        decode->task = NULL;
+    }
+
+    if(decode->pool) {
+        vQueueDelete(decode->pool);
+        decode->pool = NULL;
+    }
+
+    if(decode->chunks) {
+        vQueueDelete(decode->chunks);
+        decode->chunks = NULL;
+    }
+
+    free(decode->buffers);
+    decode->buffers = NULL;
+}
+
 static void dcgw_websocket_event_handler(void* handler_arg, esp_event_base_t base, int32_t event_id, void* event_data) {
     discord_handle_t client = (discord_handle_t) handler_arg;
     esp_websocket_event_data_t* data = (esp_websocket_event_data_t*) event_data;
+    discord_gateway_state_t state = client->state;
 
     if(data->op_code == WS_TRANSPORT_OPCODES_PONG) { // ignore PONG frame
         return;
@@ -138,8 +627,10 @@ static void dcgw_websocket_event_handler(void* handler_arg, esp_event_base_t bas
             break;
 
         case WEBSOCKET_EVENT_DATA:
-            if(data->op_code == WS_TRANSPORT_OPCODES_TEXT || data->op_code == WS_TRANSPORT_OPCODES_CLOSE) {
-                dcgw_buffer_websocket_data(client, data);
+            if(data->op_code == WS_TRANSPORT_OPCODES_TEXT
+                || data->op_code == WS_TRANSPORT_OPCODES_BINARY
+                || data->op_code == WS_TRANSPORT_OPCODES_CLOSE) {
+                dcgw_handle_websocket_data(client, data);
             }
             break;
         
@@ -159,6 +650,47 @@ static void dcgw_websocket_event_handler(void* handler_arg, esp_event_base_t bas
             DISCORD_LOGW("Unknown ws event %d", event_id);
             break;
     }
+
+    if(client->state != state) {
+        DISCORD_NOTIFY(DISCORD_NOTIFY_STATE);
+    }
+}
+
+static void dcgw_heartbeat_timer_callback(void* arg) {
+    discord_handle_t client = (discord_handle_t) arg;
+    DISCORD_NOTIFY(DISCORD_NOTIFY_HEARTBEAT);
+}
+
+static void dcgw_outbox_timer_callback(void* arg) {
+    discord_handle_t client = (discord_handle_t) arg;
+    DISCORD_NOTIFY(DISCORD_NOTIFY_OUTBOX);
+}
+
+static void dcgw_presence_timer_callback(void* arg) {
+    discord_handle_t client = (discord_handle_t) arg;
+    DISCORD_NOTIFY(DISCORD_NOTIFY_PRESENCE);
+}
+
+static void dcgw_identify_timer_callback(void* arg) {
+    discord_handle_t client = (discord_handle_t) arg;
+    DISCORD_NOTIFY(DISCORD_NOTIFY_IDENTIFY);
+}
+
+/**
+ * @brief Release identify slot reserved by the delayed identify which is not sent (ex: connection is closed in the meantime).
+ *        Slot can be released only if it's the last reserved one, otherwise identifies reserved after it would lose their pacing
+ */
+static void dcgw_identify_release(discord_handle_t client) {
+    if(client->gw_identify_at == 0)
+        return;
+
+    portENTER_CRITICAL(&dcgw_identify_lock);
+    if(dcgw_identify_next_ms[client->gw_identify_key] == client->gw_identify_at + DISCORD_GW_IDENTIFY_INTERVAL_MS) {
+        dcgw_identify_next_ms[client->gw_identify_key] = client->gw_identify_prev_ms;
+    }
+    portEXIT_CRITICAL(&dcgw_identify_lock);
+
+    client->gw_identify_at = 0;
 }
 
 esp_err_t dcgw_init(discord_handle_t client) {
@@ -170,18 +702,103 @@ esp_err_t dcgw_init(discord_handle_t client) {
     }
     
     if(!(client->gw_lock = xSemaphoreCreateMutex()) ||
-       !(client->queue = xQueueCreate(client->config->queue_size, sizeof(discord_payload_t*)))) {
+       !(client->queue = xQueueCreate(client->config->queue_size, sizeof(discord_payload_t*))) ||
+       !(client->control_queue = xQueueCreate(DISCORD_CONTROL_QUEUE_SIZE, sizeof(discord_payload_t*)))) {
         DISCORD_LOGE("Fail to create mutex/queue");
         dcgw_destroy(client);
         return ESP_FAIL;
     }
 
-    if(!(client->gw_buffer = malloc(client->config->gateway_buffer_size + 1))) {
+    client->overflow = (discord_gw_overflow_t) { 0 };
+    portMUX_INITIALIZE(&client->overflow.lock);
+
+    if(client->config->queue_policy == DISCORD_QUEUE_SPILL) {
+        size_t size = client->config->queue_overflow_size * sizeof(discord_payload_t*);
+
+        if(!(client->overflow.items = heap_caps_malloc(size, MALLOC_CAP_SPIRAM)) && !(client->overflow.items = malloc(size))) {
+            DISCORD_LOGE("Fail to allocate overflow ring");
+            dcgw_destroy(client);
+            return ESP_ERR_NO_MEM;
+        }
+
+        client->overflow.size = client->config->queue_overflow_size;
+    }
+
+    client->coalesce = (discord_gw_coalesce_t) { 0 };
+
+    if(client->config->queue_policy == DISCORD_QUEUE_COALESCE) {
+        if(!(client->coalesce.lock = xSemaphoreCreateMutex()) ||
+           !(client->coalesce.items = malloc(client->config->queue_size * sizeof(discord_payload_t*)))) {
+            DISCORD_LOGE("Fail to allocate coalesce scratch");
+            dcgw_destroy(client);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if(!(client->gw_buffer = malloc(DCGW_CLOSE_BUFFER_SIZE + 1))) {
         DISCORD_LOGE("Fail to allocate buffer");
         dcgw_destroy(client);
         return ESP_FAIL;
     }
 
+    if(!(client->gw_decoder = discord_payload_decoder_create(client->config->gateway_buffer_size, dcgw_dispatch_event_is_required, client))) {
+        DISCORD_LOGE("Fail to create payload decoder");
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    if(client->config->gateway_compression && !(client->gw_inflater = malloc(sizeof(struct discord_gw_inflater)))) {
+        DISCORD_LOGE("Fail to allocate inflate context");
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    if(client->config->gateway_decode != DISCORD_GW_DECODE_INLINE && dcgw_decode_start(client) != ESP_OK) {
+        DISCORD_LOGE("Fail to start decode task");
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    esp_timer_create_args_t timer_args = {
+        .callback = dcgw_heartbeat_timer_callback,
+        .arg = client,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "discord_heartbeat"
+    };
+
+    if(esp_timer_create(&timer_args, &client->heartbeater.timer) != ESP_OK) {
+        DISCORD_LOGE("Fail to create heartbeat timer");
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    timer_args.callback = dcgw_outbox_timer_callback;
+    timer_args.name = "discord_outbox";
+
+    if(esp_timer_create(&timer_args, &client->gw_outbox.timer) != ESP_OK) {
+        DISCORD_LOGE("Fail to create outbox timer");
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    timer_args.callback = dcgw_presence_timer_callback;
+    timer_args.name = "discord_presence";
+
+    if(esp_timer_create(&timer_args, &client->gw_presence.timer) != ESP_OK) {
+        DISCORD_LOGE("Fail to create presence timer");
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    timer_args.callback = dcgw_identify_timer_callback;
+    timer_args.name = "discord_identify";
+
+    if(esp_timer_create(&timer_args, &client->gw_identify_timer) != ESP_OK) {
+        DISCORD_LOGE("Fail to create identify timer");
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
     dcgw_heartbeat_stop(client);
     client->last_sequence_number = DISCORD_NULL_SEQUENCE_NUMBER;
     client->close_reason = DISCORD_CLOSE_REASON_NOT_REQUESTED;
@@ -195,7 +812,7 @@ esp_err_t dcgw_init(discord_handle_t client) {
     
     esp_websocket_client_config_t ws_cfg = {
         .uri = DISCORD_GW_URL,
-        .buffer_size = 512,
+        .buffer_size = DISCORD_GW_WS_BUFFER_SIZE,
 #ifndef CONFIG_ESP_TLS_SKIP_SERVER_CERT_VERIFY
         .cert_pem = (const char*) gateway_crt,
 #endif
@@ -218,34 +835,310 @@ esp_err_t dcgw_init(discord_handle_t client) {
     return ESP_OK;
 }
 
+/**
+ * @brief Lower value means higher priority. Heartbeat keeps the connection alive, so it goes first
+ */
+static uint8_t dcgw_outbound_priority(int op) {
+    switch(op) {
+        case DISCORD_OP_HEARTBEAT: return 0;
+        case DISCORD_OP_IDENTIFY:
+        case DISCORD_OP_RESUME: return 1;
+        default: return 2;
+    }
+}
+
+static void dcgw_outbox_clear(discord_handle_t client) {
+    discord_gw_outbox_t* outbox = &client->gw_outbox;
+
+    if(outbox->timer) {
+        esp_timer_stop(outbox->timer);
+    }
+
+    while(outbox->head) {
+        discord_gw_outbound_t* next = outbox->head->next;
+        free(outbox->head->data);
+        free(outbox->head);
+        outbox->head = next;
+    }
+
+    outbox->len = 0;
+}
+
+/**
+ * @brief Reset rate limit for the new connection (limit is applied per connection)
+ */
+static void dcgw_outbox_reset(discord_handle_t client) {
+    dcgw_outbox_clear(client);
+    client->gw_outbox.tokens = DISCORD_GW_RATELIMIT_TOKENS;
+    client->gw_outbox.refill_ms = discord_tick_ms();
+}
+
+/**
+ * @brief Drop the newest payload which is not a control one, to make room for control payload.
+ *        If outbox contains only control payloads, nothing is dropped and outbox grows over its size
+ */
+static void dcgw_outbox_evict(discord_handle_t client) {
+    discord_gw_outbox_t* outbox = &client->gw_outbox;
+    discord_gw_outbound_t** last = NULL;
+
+    // payloads are ordered by priority, so the last one is the newest one with the lowest priority
+    for(discord_gw_outbound_t** next = &outbox->head; *next; next = &(*next)->next) {
+        last = next;
+    }
+
+    if(!last || dcgw_outbound_priority((*last)->op) <= 1) {
+        return;
+    }
+
+    discord_gw_outbound_t* item = *last;
+    DISCORD_LOGW("Gateway outbox is full, payload (op: %d) is dropped", item->op);
+    *last = NULL;
+    outbox->len--;
+    free(item->data);
+    free(item);
+}
+
+static esp_err_t dcgw_outbox_push(discord_handle_t client, int op, char* data) {
+    discord_gw_outbox_t* outbox = &client->gw_outbox;
+    discord_gw_outbound_t** next = &outbox->head;
+    uint8_t priority = dcgw_outbound_priority(op);
+
+    if(op == DISCORD_OP_PRESENCE_UPDATE) { // newer presence supersedes the pending one
+        for(discord_gw_outbound_t* item = outbox->head; item; item = item->next) {
+            if(item->op == op) {
+                DISCORD_LOGD("Pending presence update is replaced");
+                free(item->data);
+                item->data = data;
+                return ESP_OK;
+            }
+        }
+    }
+
+    if(outbox->len >= DISCORD_GW_OUTBOX_SIZE) {
+        if(priority > 1) {
+            DISCORD_LOGW("Gateway outbox is full");
+            free(data);
+            return ESP_ERR_NO_MEM;
+        }
+
+        dcgw_outbox_evict(client); // control payloads are never dropped
+    }
+
+    discord_gw_outbound_t* item = cu_ctor(discord_gw_outbound_t,
+        .op = op,
+        .data = data
+    );
+
+    if(!item) {
+        free(data);
+        return ESP_ERR_NO_MEM;
+    }
+
+    while(*next && dcgw_outbound_priority((*next)->op) <= priority) {
+        next = &(*next)->next;
+    }
+
+    item->next = *next;
+    *next = item;
+    outbox->len++;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Take token for the payload. Payloads which are not control ones cannot use the reserved tokens
+ * @return Zero if token is taken, otherwise number of milliseconds until it can be taken
+ */
+static uint64_t dcgw_outbox_take_token(discord_handle_t client, int op) {
+    discord_gw_outbox_t* outbox = &client->gw_outbox;
+    uint64_t now = discord_tick_ms();
+    int refilled = (now - outbox->refill_ms) / DISCORD_GW_RATELIMIT_REFILL_MS;
+
+    if(refilled > 0) {
+        outbox->tokens = outbox->tokens + refilled > DISCORD_GW_RATELIMIT_TOKENS ? DISCORD_GW_RATELIMIT_TOKENS : outbox->tokens + refilled;
+        outbox->refill_ms = outbox->tokens == DISCORD_GW_RATELIMIT_TOKENS ? now : outbox->refill_ms + refilled * DISCORD_GW_RATELIMIT_REFILL_MS;
+    }
+
+    int required = dcgw_outbound_priority(op) > 1 ? DISCORD_GW_RATELIMIT_RESERVED + 1 : 1;
+
+    if(outbox->tokens >= required) {
+        outbox->tokens--;
+        return 0;
+    }
+
+    return (required - outbox->tokens) * DISCORD_GW_RATELIMIT_REFILL_MS - (now - outbox->refill_ms);
+}
+
+/**
+ * @brief Send pending payloads until the rate limit is exhausted. Gateway needs to be locked
+ */
+static esp_err_t dcgw_outbox_flush_locked(discord_handle_t client) {
+    discord_gw_outbox_t* outbox = &client->gw_outbox;
+
+    while(outbox->head) {
+        discord_gw_outbound_t* item = outbox->head;
+        uint64_t delay = dcgw_outbox_take_token(client, item->op);
+
+        if(delay > 0) {
+            DISCORD_LOGD("Gateway rate limit reached, %d payload(s) are pending for %d ms", outbox->len, (int) delay);
+            esp_timer_stop(outbox->timer);
+            esp_timer_start_once(outbox->timer, delay * 1000);
+            return ESP_OK;
+        }
+
+        outbox->head = item->next;
+        outbox->len--;
+
+        DISCORD_LOGD("%s", item->data);
+
+        int sent_bytes = esp_websocket_client_send_text(client->ws, item->data, strlen(item->data), 5000 / portTICK_PERIOD_MS); // 5sec timeout
+        free(item->data);
+        free(item);
+
+        if(sent_bytes == ESP_FAIL) {
+            DISCORD_LOGW("Fail to send data to gateway");
+            client->state = DISCORD_STATE_ERROR;
+            DISCORD_NOTIFY(DISCORD_NOTIFY_STATE);
+            return ESP_FAIL;
+        }
+    }
+
+    return ESP_OK;
+}
+
 esp_err_t dcgw_send(discord_handle_t client, discord_payload_t* payload) {
     DISCORD_LOG_FOO();
 
     if(xSemaphoreTake(client->gw_lock, 5000 / portTICK_PERIOD_MS) != pdTRUE) { // 5sec timeout
         DISCORD_LOGW("Gateway is locked");
+        discord_payload_free(payload);
         return ESP_FAIL;
     }
     
+    int op = payload->op;
     char* payload_raw = discord_json_serialize(payload);
     discord_payload_free(payload);
 
-    DISCORD_LOGD("%s", payload_raw);
-
-    int sent_bytes = esp_websocket_client_send_text(client->ws, payload_raw, strlen(payload_raw), 5000 / portTICK_PERIOD_MS); // 5sec timeout
-    free(payload_raw);
+    esp_err_t err = payload_raw ? dcgw_outbox_push(client, op, payload_raw) : ESP_FAIL;
 
-    if(sent_bytes == ESP_FAIL) {
-        DISCORD_LOGW("Fail to send data to gateway");
-        client->state = DISCORD_STATE_ERROR;
-        xSemaphoreGive(client->gw_lock);
-        return ESP_FAIL;
+    if(err == ESP_OK) {
+        err = dcgw_outbox_flush_locked(client);
     }
     
     xSemaphoreGive(client->gw_lock);
 
+    return err;
+}
+
+esp_err_t dcgw_presence_set(discord_handle_t client, char* json) {
+    discord_gw_presence_t* presence = &client->gw_presence;
+    char* replaced = NULL;
+    const char* current;
+
+    xSemaphoreTake(presence->lock, portMAX_DELAY);
+    current = presence->pending ? presence->pending : presence->sent;
+
+    if(current && strcmp(current, json) == 0) {
+        replaced = json; // unchanged
+    } else {
+        replaced = presence->pending;
+        presence->pending = json;
+    }
+    xSemaphoreGive(presence->lock);
+
+    if(replaced == json) {
+        DISCORD_LOGD("Presence is not changed");
+        free(json);
+        return ESP_OK;
+    }
+
+    free(replaced);
+
+    return dcgw_presence_flush(client);
+}
+
+/**
+ * @brief Send pending presence or schedule it. Presence lock needs to be held, so the update window
+ *        is checked and the presence is sent by one task at a time
+ */
+static esp_err_t dcgw_presence_flush_locked(discord_handle_t client) {
+    discord_gw_presence_t* presence = &client->gw_presence;
+
+    if(client->state != DISCORD_STATE_CONNECTED || !presence->timer || !presence->pending) {
+        return ESP_OK; // it will be sent once connected
+    }
+
+    uint64_t elapsed = discord_tick_ms() - presence->sent_ms;
+
+    if(presence->sent_ms > 0 && elapsed < DISCORD_PRESENCE_INTERVAL_MS) {
+        if(!esp_timer_is_active(presence->timer)) {
+            esp_timer_start_once(presence->timer, (DISCORD_PRESENCE_INTERVAL_MS - elapsed) * 1000);
+        }
+
+        return ESP_OK;
+    }
+
+    char* data = strdup(presence->pending);
+    esp_err_t err = data ? dcgw_send(client, cu_ctor(discord_payload_t,
+        .op = DISCORD_OP_PRESENCE_UPDATE,
+        .d = data
+    )) : ESP_ERR_NO_MEM;
+
+    if(err != ESP_OK) { // keep it for the next flush
+        DISCORD_LOGW("Fail to send presence update. Retrying later...");
+
+        if(!esp_timer_is_active(presence->timer)) {
+            esp_timer_start_once(presence->timer, (uint64_t) DISCORD_PRESENCE_INTERVAL_MS * 1000);
+        }
+
+        return err;
+    }
+
+    free(presence->sent);
+    presence->sent = presence->pending;
+    presence->pending = NULL;
+    presence->sent_ms = discord_tick_ms();
+
     return ESP_OK;
 }
 
+esp_err_t dcgw_presence_flush(discord_handle_t client) {
+    discord_gw_presence_t* presence = &client->gw_presence;
+
+    xSemaphoreTake(presence->lock, portMAX_DELAY);
+    esp_err_t err = dcgw_presence_flush_locked(client);
+    xSemaphoreGive(presence->lock);
+
+    return err;
+}
+
+/**
+ * @brief New session starts without presence, so the last one needs to be sent again
+ */
+static void dcgw_presence_restore(discord_handle_t client) {
+    discord_gw_presence_t* presence = &client->gw_presence;
+
+    xSemaphoreTake(presence->lock, portMAX_DELAY);
+    if(!presence->pending) {
+        presence->pending = presence->sent;
+        presence->sent = NULL;
+    }
+    presence->sent_ms = 0;
+    xSemaphoreGive(presence->lock);
+}
+
+esp_err_t dcgw_outbox_flush(discord_handle_t client) {
+    if(xSemaphoreTake(client->gw_lock, 5000 / portTICK_PERIOD_MS) != pdTRUE) { // 5sec timeout
+        DISCORD_LOGW("Gateway is locked");
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = dcgw_outbox_flush_locked(client);
+    xSemaphoreGive(client->gw_lock);
+
+    return err;
+}
+
 esp_err_t dcgw_get_close_desc(discord_handle_t client, char** out_description) {
     if(! client || ! out_description) {
         return ESP_ERR_INVALID_ARG;
@@ -257,6 +1150,38 @@ esp_err_t dcgw_get_close_desc(discord_handle_t client, char** out_description) {
     return ESP_OK;
 }
 
+discord_reconnect_rule_t dcgw_reconnect_rule(discord_close_code_t code) {
+    switch(code) {
+        case DISCORD_CLOSEOP_AUTHENTICATION_FAILED:
+        case DISCORD_CLOSEOP_INVALID_SHARD:
+        case DISCORD_CLOSEOP_SHARDING_REQUIRED:
+        case DISCORD_CLOSEOP_INVALID_API_VERSION:
+        case DISCORD_CLOSEOP_INVALID_INTENTS:
+        case DISCORD_CLOSEOP_DISALLOWED_INTENTS:
+            return DISCORD_RECONNECT_NEVER;
+
+        case DISCORD_CLOSEOP_INVALID_SEQ:
+        case DISCORD_CLOSEOP_SESSION_TIMED_OUT:
+            return DISCORD_RECONNECT_NEW_SESSION;
+
+        case DISCORD_CLOSEOP_RATE_LIMITED:
+            return DISCORD_RECONNECT_BACKOFF;
+
+        default:
+            return DISCORD_RECONNECT_RESUME;
+    }
+}
+
+uint32_t dcgw_reconnect_delay(discord_handle_t client, uint8_t attempt) {
+    uint64_t cap = (uint64_t) client->config->reconnect_base_ms << (attempt < 16 ? attempt : 16);
+
+    if(cap > client->config->reconnect_max_ms) {
+        cap = client->config->reconnect_max_ms;
+    }
+
+    return esp_random() % (cap + 1);
+}
+
 bool dcgw_is_open(discord_handle_t client) {
     return client && client->state >= DISCORD_STATE_OPEN;
 }
@@ -275,6 +1200,214 @@ esp_err_t dcgw_open(discord_handle_t client) {
     return dcgw_start(client);
 }
 
+bool dcgw_can_resume(discord_handle_t client) {
+    return client
+        && client->session
+        && client->session->session_id
+        && client->last_sequence_number != DISCORD_NULL_SEQUENCE_NUMBER;
+}
+
+esp_err_t dcgw_session_invalidate(discord_handle_t client) {
+    if(! client) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    DISCORD_LOG_FOO();
+
+    discord_session_free(client->session);
+    client->session = NULL;
+    client->last_sequence_number = DISCORD_NULL_SEQUENCE_NUMBER;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Get wall clock time
+ * @return false if wall clock is not set (ex: SNTP is not used)
+ */
+static bool dcgw_wall_clock(int64_t* out_now) {
+    *out_now = (int64_t) time(NULL);
+    return *out_now >= DCGW_WALL_CLOCK_MIN;
+}
+
+/**
+ * @brief Save gateway info into NVS. Flash is written only if the cached record is changed
+ */
+static void dcgw_info_save(discord_handle_t client) {
+    discord_gw_info_t* info = &client->gw_info;
+    dcgw_info_record_t record, saved;
+    size_t saved_size = sizeof(saved);
+
+    memset(&record, 0, sizeof(record)); // padding is compared as well
+    record.token_hash = estrn_hash(ESTR_HASH_INIT, client->config->token, strlen(client->config->token));
+    memcpy(record.url, info->url, sizeof(record.url));
+    record.shards = info->shards;
+    record.max_concurrency = info->max_concurrency;
+    record.remaining = info->remaining;
+    record.reset_at = info->reset_at;
+    record.expires_at = info->expires_at;
+
+    nvs_handle_t nvs;
+
+    if(nvs_open(DISCORD_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        DISCORD_LOGD("Gateway info cannot be cached (NVS is not initialized?)");
+        return;
+    }
+
+    if(nvs_get_blob(nvs, DISCORD_NVS_KEY_GATEWAY_BOT, &saved, &saved_size) == ESP_OK
+        && saved_size == sizeof(saved) && memcmp(&saved, &record, sizeof(record)) == 0) {
+        DISCORD_LOGD("Cached gateway info is up to date");
+    } else {
+        nvs_set_blob(nvs, DISCORD_NVS_KEY_GATEWAY_BOT, &record, sizeof(record));
+        nvs_commit(nvs);
+    }
+
+    nvs_close(nvs);
+}
+
+/**
+ * @brief Load gateway info from NVS if it's not expired
+ */
+static esp_err_t dcgw_info_load_cached(discord_handle_t client) {
+    dcgw_info_record_t record;
+    size_t record_size = sizeof(record);
+    nvs_handle_t nvs;
+    esp_err_t err;
+    int64_t now;
+
+    if((err = nvs_open(DISCORD_NVS_NAMESPACE, NVS_READONLY, &nvs)) != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_get_blob(nvs, DISCORD_NVS_KEY_GATEWAY_BOT, &record, &record_size);
+    nvs_close(nvs);
+
+    if(err != ESP_OK || record_size != sizeof(record) || record.token_hash != estrn_hash(ESTR_HASH_INIT, client->config->token, strlen(client->config->token))) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    bool clock = dcgw_wall_clock(&now);
+
+    // without wall clock cache cannot expire, but it's not used once the session start limit is exhausted
+    if((clock && (record.expires_at == 0 || now >= record.expires_at)) || record.remaining == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    discord_gw_info_t* info = &client->gw_info;
+
+    memcpy(info->url, record.url, sizeof(info->url));
+    info->url[sizeof(info->url) - 1] = '\0';
+    info->shards = record.shards;
+    info->max_concurrency = record.max_concurrency;
+    info->remaining = record.remaining;
+    info->reset_ms = clock && record.reset_at > now ? discord_tick_ms() + (record.reset_at - now) * 1000 : 0;
+    info->reset_at = record.reset_at;
+    info->expires_at = record.expires_at;
+
+    return ESP_OK;
+}
+
+static esp_err_t dcgw_info_fetch(discord_handle_t client) {
+    discord_gateway_bot_t* gateway_bot = NULL;
+    char* data = NULL;
+    int data_len = 0;
+    esp_err_t err;
+    int64_t now;
+
+    // api is not initialized while gateway is not connected, so the request does not use it
+    if((err = dcapi_get_oneshot(client, "/gateway/bot", &data, &data_len)) != ESP_OK) {
+        return err;
+    }
+
+    gateway_bot = discord_json_deserialize_(gateway_bot, data, data_len);
+    free(data);
+
+    if(!gateway_bot) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    discord_gw_info_t* info = &client->gw_info;
+
+    if(strlen(gateway_bot->url) < sizeof(info->url)) {
+        strcpy(info->url, gateway_bot->url);
+    } else {
+        info->url[0] = '\0'; // use default one
+    }
+
+    info->shards = gateway_bot->shards;
+    info->max_concurrency = gateway_bot->max_concurrency;
+    info->remaining = gateway_bot->remaining;
+    info->reset_ms = discord_tick_ms() + gateway_bot->reset_after;
+
+    if(dcgw_wall_clock(&now)) {
+        info->reset_at = now + gateway_bot->reset_after / 1000;
+        info->expires_at = now + DISCORD_GW_INFO_TTL_SEC;
+    } else {
+        info->reset_at = 0;
+        info->expires_at = 0;
+    }
+
+    discord_gateway_bot_free(gateway_bot);
+    dcgw_info_save(client);
+
+    return ESP_OK;
+}
+
+esp_err_t dcgw_info_load(discord_handle_t client) {
+    discord_gw_info_t* info = &client->gw_info;
+    esp_err_t err;
+
+    if(info->loaded)
+        return ESP_OK;
+
+    if(dcgw_info_load_cached(client) == ESP_OK) {
+        DISCORD_LOGD("Gateway info loaded from cache");
+    } else if((err = dcgw_info_fetch(client)) != ESP_OK) {
+        DISCORD_LOGW("Fail to get gateway info. Default gateway url will be used");
+        return err; // try again on the next connection
+    }
+
+    info->loaded = true;
+
+    DISCORD_LOGD("Gateway info [url: %s, shards: %d, max_concurrency: %d, remaining session starts: %d]",
+        info->url, info->shards, info->max_concurrency, (int) info->remaining
+    );
+
+    if(info->shards > 1 && client->config->shard_count < info->shards) {
+        DISCORD_LOGW("Discord recommends %d shards (configured: %d)", info->shards, client->config->shard_count);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Point websocket client to the resume gateway url if session can be resumed, otherwise to the default gateway url
+ */
+static esp_err_t dcgw_set_uri(discord_handle_t client) {
+    bool resume = dcgw_can_resume(client) && client->session->resume_gateway_url;
+
+    if(!resume) {
+        dcgw_info_load(client);
+    }
+
+    const char* host = resume
+        ? client->session->resume_gateway_url
+        : (client->gw_info.url[0] ? client->gw_info.url : DISCORD_GW_HOST);
+
+    char* uri = estr_cat(host, DISCORD_GW_QUERY, client->gw_inflater ? DISCORD_GW_QUERY_COMPRESS : "");
+
+    if(!uri) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    DISCORD_LOGD("Gateway uri: %s", uri);
+
+    esp_err_t err = esp_websocket_client_set_uri(client->ws, uri);
+    free(uri);
+
+    return err;
+}
+
 esp_err_t dcgw_start(discord_handle_t client) {
     DISCORD_LOG_FOO();
 
@@ -284,8 +1417,21 @@ esp_err_t dcgw_start(discord_handle_t client) {
     }
     
     client->close_reason = DISCORD_CLOSE_REASON_NOT_REQUESTED;
-    esp_err_t err = esp_websocket_client_start(client->ws);
+    client->gw_buffer_len = 0;
+    xSemaphoreTake(client->gw_lock, portMAX_DELAY);
+    dcgw_outbox_reset(client);
+    xSemaphoreGive(client->gw_lock);
+    dcgw_decode_drain(client); // decoder is used by decode task
+    discord_payload_decoder_reset(client->gw_decoder);
+    dcgw_inflater_reset(client); // every connection starts new zlib stream
+    esp_err_t err = dcgw_set_uri(client);
+
+    if(err == ESP_OK) {
+        err = esp_websocket_client_start(client->ws);
+    }
+
     client->state = err == ESP_OK ? DISCORD_STATE_OPEN : DISCORD_STATE_ERROR;
+    DISCORD_NOTIFY(DISCORD_NOTIFY_STATE);
     
     return err;
 }
@@ -303,13 +1449,27 @@ esp_err_t dcgw_close(discord_handle_t client, discord_gateway_close_reason_t rea
     if(client->gw_lock) { xSemaphoreTake(client->gw_lock, portMAX_DELAY); } // wait to unlock
     client->close_reason = reason;
     dcgw_heartbeat_stop(client);
-    client->last_sequence_number = DISCORD_NULL_SEQUENCE_NUMBER;
     
     if(esp_websocket_client_is_connected(client->ws)) {
-        esp_websocket_client_close(client->ws, portMAX_DELAY);
+        if(reason == DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED || reason == DISCORD_CLOSE_REASON_RECONNECT) {
+            // Normal close frame invalidates the session on the Discord side,
+            // so connection is dropped without it in order to be able to resume the session.
+            // ws task will not report disconnection in this case, that's why the state is set here.
+            esp_websocket_client_stop(client->ws);
+            client->state = DISCORD_STATE_DISCONNECTED;
+        } else {
+            esp_websocket_client_close(client->ws, portMAX_DELAY);
+        }
     }
 
     client->gw_buffer_len = 0;
+    dcgw_outbox_clear(client);
+
+    if(client->gw_identify_timer) {
+        esp_timer_stop(client->gw_identify_timer);
+    }
+    dcgw_identify_release(client);
+    dcgw_decode_drain(client); // payloads of the closed connection
     dcgw_queue_flush(client);
     if(client->gw_lock) { xSemaphoreGive(client->gw_lock); }
 
@@ -326,8 +1486,37 @@ esp_err_t dcgw_destroy(discord_handle_t client) {
     dcgw_close(client, DISCORD_CLOSE_REASON_DESTROY);
     esp_websocket_client_destroy(client->ws);
     client->ws = NULL;
+    dcgw_decode_stop(client);
     free(client->gw_buffer);
     client->gw_buffer = NULL;
+    free(client->gw_inflater);
+    client->gw_inflater = NULL;
+    discord_payload_decoder_destroy(client->gw_decoder);
+    client->gw_decoder = NULL;
+
+    if(client->heartbeater.timer) {
+        esp_timer_delete(client->heartbeater.timer);
+        client->heartbeater.timer = NULL;
+    }
+
+    if(client->gw_outbox.timer) {
+        esp_timer_delete(client->gw_outbox.timer);
+        client->gw_outbox.timer = NULL;
+    }
+
+    if(client->gw_presence.timer) {
+        xSemaphoreTake(client->gw_presence.lock, portMAX_DELAY); // wait for the flush in progress
+        esp_timer_stop(client->gw_presence.timer);
+        esp_timer_delete(client->gw_presence.timer);
+        client->gw_presence.timer = NULL;
+        xSemaphoreGive(client->gw_presence.lock);
+    }
+
+    if(client->gw_identify_timer) {
+        esp_timer_stop(client->gw_identify_timer);
+        esp_timer_delete(client->gw_identify_timer);
+        client->gw_identify_timer = NULL;
+    }
 
     if(client->gw_lock) {
         xSemaphoreTake(client->gw_lock, portMAX_DELAY); // wait to unlock
@@ -341,19 +1530,35 @@ esp_err_t dcgw_destroy(discord_handle_t client) {
         client->queue = NULL;
     }
 
+    if(client->control_queue) {
+        vQueueDelete(client->control_queue);
+        client->control_queue = NULL;
+    }
+
+    free(client->overflow.items);
+    client->overflow.items = NULL;
+
+    if(client->coalesce.lock) {
+        vSemaphoreDelete(client->coalesce.lock);
+        client->coalesce.lock = NULL;
+    }
+
+    free(client->coalesce.items);
+    client->coalesce.items = NULL;
+
     client->state = DISCORD_STATE_UNKNOWN;
 
     return ESP_OK;
 }
 
 esp_err_t dcgw_queue_flush(discord_handle_t client) {
-    if(!client || !client->queue) {
+    if(!client || !client->queue || !client->control_queue) {
         return ESP_ERR_INVALID_ARG;
     }
     
     discord_payload_t* payload = NULL;
 
-    while(xQueueReceive(client->queue, &payload, (TickType_t) 0) == pdPASS) {
+    while(dcgw_queue_receive(client, &payload)) {
         discord_payload_free(payload);
     }
 
@@ -369,39 +1574,163 @@ static esp_err_t dcgw_heartbeat_start(discord_handle_t client, discord_hello_t*
     client->heartbeater.received_ack = true; // True to prevent first ack checking
     client->heartbeater.interval = hello->heartbeat_interval;
     client->heartbeater.tick_ms = discord_tick_ms();
+
+    if(esp_timer_start_periodic(client->heartbeater.timer, (uint64_t) client->heartbeater.interval * 1000) != ESP_OK) {
+        DISCORD_LOGE("Fail to start heartbeat timer");
+        return ESP_FAIL;
+    }
+
     client->heartbeater.running = true;
 
     return ESP_OK;
 }
 
-esp_err_t dcgw_heartbeat_send_if_expired(discord_handle_t client) {
-    if(client->heartbeater.running && discord_tick_ms() - client->heartbeater.tick_ms > client->heartbeater.interval) {
-        DISCORD_LOGD("Heartbeat");
+esp_err_t dcgw_heartbeat_send(discord_handle_t client) {
+    if(!client->heartbeater.running)
+        return ESP_OK;
 
-        client->heartbeater.tick_ms = discord_tick_ms();
+    DISCORD_LOGD("Heartbeat");
 
-        if(!client->heartbeater.received_ack) {
-            DISCORD_LOGW("ACK has not been received since the last heartbeat. Reconnection will follow using IDENTIFY (RESUME is not implemented yet)");
-            dcgw_close(client, DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED);
-            return ESP_ERR_INVALID_STATE;
-        }
+    client->heartbeater.tick_ms = discord_tick_ms();
 
-        client->heartbeater.received_ack = false;
-        int s = client->last_sequence_number;
+    if(!client->heartbeater.received_ack) {
+        DISCORD_LOGW("ACK has not been received since the last heartbeat. Reconnection will follow");
+        portENTER_CRITICAL(&client->heartbeater.latency.lock);
+        client->heartbeater.latency.missed++;
+        portEXIT_CRITICAL(&client->heartbeater.latency.lock);
+        dcgw_close(client, DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED);
+        return ESP_ERR_INVALID_STATE;
+    }
 
-        // todo: memcheck
-        return dcgw_send(client, cu_ctor(discord_payload_t,
-            .op = DISCORD_OP_HEARTBEAT,
-            .d = (discord_heartbeat_t*) &s
-        ));
+    client->heartbeater.received_ack = false;
+    int s = client->last_sequence_number;
+
+    // todo: memcheck
+    return dcgw_send(client, cu_ctor(discord_payload_t,
+        .op = DISCORD_OP_HEARTBEAT,
+        .d = (discord_heartbeat_t*) &s
+    ));
+}
+
+esp_err_t dcgw_get_latency(discord_handle_t client, discord_gateway_latency_t* out_latency) {
+    discord_latency_t* latency = &client->heartbeater.latency;
+    uint16_t samples[DISCORD_LATENCY_SAMPLES];
+
+    portENTER_CRITICAL(&latency->lock);
+    uint8_t len = latency->len;
+    memcpy(samples, latency->samples, len * sizeof(uint16_t));
+    *out_latency = (discord_gateway_latency_t) {
+        .last_ms = latency->last_ms,
+        .samples = len,
+        .missed = latency->missed
+    };
+    portEXIT_CRITICAL(&latency->lock);
+
+    if(len == 0) {
+        return ESP_OK;
+    }
+
+    uint32_t sum = 0;
+
+    for(uint8_t i = 0; i < len; i++) { // insertion sort, there are only few samples
+        uint16_t sample = samples[i];
+        int j = i - 1;
+
+        for(; j >= 0 && samples[j] > sample; j--) {
+            samples[j + 1] = samples[j];
+        }
+
+        samples[j + 1] = sample;
+        sum += sample;
     }
 
+    out_latency->min_ms = samples[0];
+    out_latency->avg_ms = sum / len;
+    out_latency->p99_ms = samples[(len * 99 + 99) / 100 - 1];
+
     return ESP_OK;
 }
 
-esp_err_t dcgw_identify(discord_handle_t client) {
+/**
+ * @brief Store round-trip time of the acknowledged heartbeat and notify subscribers about updated statistics
+ */
+static void dcgw_latency_record(discord_handle_t client, uint64_t rtt_ms) {
+    discord_latency_t* latency = &client->heartbeater.latency;
+
+    portENTER_CRITICAL(&latency->lock);
+    latency->last_ms = rtt_ms;
+    latency->samples[latency->head] = rtt_ms > UINT16_MAX ? UINT16_MAX : rtt_ms;
+    latency->head = (latency->head + 1) % DISCORD_LATENCY_SAMPLES;
+
+    if(latency->len < DISCORD_LATENCY_SAMPLES) {
+        latency->len++;
+    }
+    portEXIT_CRITICAL(&latency->lock);
+
+    DISCORD_LOGD("Heartbeat latency %d ms", (int) rtt_ms);
+
+    if(DISCORD_EVENT_HAS_SUBSCRIBERS(DISCORD_EVENT_GATEWAY_LATENCY)) {
+        discord_gateway_latency_t stats;
+        dcgw_get_latency(client, &stats);
+        DISCORD_EVENT_FIRE(DISCORD_EVENT_GATEWAY_LATENCY, &stats);
+    }
+}
+
+esp_err_t dcgw_identify(discord_handle_t client, uint32_t delay_ms) {
     DISCORD_LOG_FOO();
 
+    discord_gw_info_t* info = &client->gw_info;
+    uint8_t max_concurrency = client->config->max_concurrency
+        ? client->config->max_concurrency
+        : (info->max_concurrency ? info->max_concurrency : DISCORD_DEFAULT_MAX_CONCURRENCY);
+    // identify budget is shared by all shards (clients) of the application
+    uint8_t key = (client->config->shard_id % max_concurrency) % DISCORD_GW_IDENTIFY_KEYS;
+    uint64_t now = discord_tick_ms();
+
+    if(info->loaded && info->remaining == 0 && info->reset_ms > now + delay_ms) {
+        DISCORD_LOGW("Session start limit is exhausted");
+        delay_ms = info->reset_ms - now;
+    }
+
+    dcgw_identify_release(client); // identify which is still pending is replaced by this one
+
+    portENTER_CRITICAL(&dcgw_identify_lock);
+    uint64_t prev = dcgw_identify_next_ms[key];
+    uint64_t at = prev > now + delay_ms ? prev : now + delay_ms;
+    dcgw_identify_next_ms[key] = at + DISCORD_GW_IDENTIFY_INTERVAL_MS;
+    portEXIT_CRITICAL(&dcgw_identify_lock);
+
+    if(at > now) {
+        DISCORD_LOGI("Identify of shard %d is delayed by %d ms", client->config->shard_id, (int) (at - now));
+        client->gw_identify_key = key;
+        client->gw_identify_at = at;
+        client->gw_identify_prev_ms = prev;
+        esp_timer_stop(client->gw_identify_timer);
+        return esp_timer_start_once(client->gw_identify_timer, (at - now) * 1000);
+    }
+
+    return dcgw_identify_send(client);
+}
+
+esp_err_t dcgw_identify_send(discord_handle_t client) {
+    DISCORD_LOG_FOO();
+
+    if(client->state != DISCORD_STATE_CONNECTING) {
+        DISCORD_LOGD("Connection is closed in the meantime");
+        dcgw_identify_release(client);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    client->gw_identify_at = 0; // reserved slot is used
+
+    if(client->gw_info.loaded) {
+        if(client->gw_info.remaining > 0) {
+            client->gw_info.remaining--;
+        }
+
+        dcgw_info_save(client); // keep the remaining number of session starts for the next boot
+    }
+
     // todo: memchecks
     return dcgw_send(client, cu_ctor(discord_payload_t,
         .op = DISCORD_OP_IDENTIFY,
@@ -412,7 +1741,25 @@ esp_err_t dcgw_identify(discord_handle_t client) {
                 .os = estr_cat("esp-idf (", esp_get_idf_version(), ")"),
                 .browser = strdup("esp-discord (" DISCORD_VER_STRING ")"),
                 .device = strdup(CONFIG_IDF_TARGET)
-            )
+            ),
+            .shard_id = client->config->shard_id,
+            .shard_count = client->config->shard_count
+        )
+    ));
+}
+
+static esp_err_t dcgw_resume(discord_handle_t client) {
+    DISCORD_LOG_FOO();
+
+    DISCORD_LOGD("Resuming [session: %s, seq: %d]", client->session->session_id, client->last_sequence_number);
+
+    // todo: memchecks
+    return dcgw_send(client, cu_ctor(discord_payload_t,
+        .op = DISCORD_OP_RESUME,
+        .d = cu_ctor(discord_resume_t,
+            .token = strdup(client->config->token),
+            .session_id = strdup(client->session->session_id),
+            .seq = client->last_sequence_number
         )
     ));
 }
@@ -435,7 +1782,7 @@ static esp_err_t dcgw_dispatch(discord_handle_t client, discord_payload_t* paylo
 
         client->state = DISCORD_STATE_CONNECTED;
         
-        DISCORD_LOGD("Identified [%s#%s (%s), session: %s]", 
+        DISCORD_LOGD("Identified [%s#%s (%" DISCORD_SNOWFLAKE_FMT "), session: %s]", 
             client->session->user->username,
             client->session->user->discriminator,
             client->session->user->id,
@@ -447,7 +1794,7 @@ static esp_err_t dcgw_dispatch(discord_handle_t client, discord_payload_t* paylo
         discord_session_t* session_clone = cu_ctor(discord_session_t,
             .session_id = strdup(_s->session_id),
             .user = cu_ctor(discord_user_t,
-                .id = strdup(_s->user->id),
+                .id = _s->user->id,
                 .bot = _s->user->bot,
                 .username = strdup(_s->user->username),
                 .discriminator = strdup(_s->user->discriminator)
@@ -459,6 +1806,23 @@ static esp_err_t dcgw_dispatch(discord_handle_t client, discord_payload_t* paylo
         DISCORD_EVENT_FIRE(DISCORD_EVENT_CONNECTED, session_clone);
         discord_session_free(session_clone);
 
+        dcgw_presence_restore(client);
+        dcgw_presence_flush(client);
+
+        return ESP_OK;
+    }
+
+    if(DISCORD_EVENT_RESUMED == payload->t) {
+        client->state = DISCORD_STATE_CONNECTED;
+
+        DISCORD_LOGD("Resumed [session: %s, seq: %d]",
+            client->session->session_id,
+            client->last_sequence_number
+        );
+
+        DISCORD_EVENT_FIRE(DISCORD_EVENT_RESUMED, NULL);
+        dcgw_presence_flush(client); // presence could be changed while disconnected
+
         return ESP_OK;
     }
 
@@ -483,16 +1847,50 @@ esp_err_t dcgw_handle_payload(discord_handle_t client, discord_payload_t* payloa
             dcgw_heartbeat_start(client, (discord_hello_t*) payload->d);
             discord_payload_free(payload);
             payload = NULL;
-            dcgw_identify(client);
+
+            if(dcgw_can_resume(client)) {
+                dcgw_resume(client);
+            } else {
+                dcgw_identify(client, 0);
+            }
+            break;
+
+        case DISCORD_OP_RECONNECT:
+            DISCORD_LOGI("Gateway requested reconnection");
+            dcgw_close(client, DISCORD_CLOSE_REASON_RECONNECT);
+            break;
+
+        case DISCORD_OP_INVALID_SESSION: {
+                bool resumable = payload->d && ((discord_invalid_session_t*) payload->d)->resumable;
+
+                DISCORD_LOGW("Session has been invalidated (resumable: %s)", resumable ? "true" : "false");
+
+                if(resumable && dcgw_can_resume(client)) {
+                    dcgw_close(client, DISCORD_CLOSE_REASON_RECONNECT); // reconnect immediately and resume
+                } else {
+                    dcgw_session_invalidate(client);
+                    client->state = DISCORD_STATE_CONNECTING; // session can be received while connected, and identify is sent only while connecting
+                    dcgw_identify(client, DISCORD_GW_INVALID_SESSION_MIN_MS
+                        + esp_random() % (DISCORD_GW_INVALID_SESSION_MAX_MS - DISCORD_GW_INVALID_SESSION_MIN_MS + 1));
+                }
+            }
             break;
         
         case DISCORD_OP_HEARTBEAT_ACK:
             DISCORD_LOGD("Heartbeat ack received");
-            client->heartbeater.received_ack = true;
+
+            if(!client->heartbeater.received_ack) { // ignore ACK which does not belong to any heartbeat
+                client->heartbeater.received_ack = true;
+                dcgw_latency_record(client, client->heartbeater.ack_tick_ms - client->heartbeater.tick_ms);
+            }
             break;
 
         case DISCORD_OP_DISPATCH:
-            dcgw_dispatch(client, payload);
+            if(dcev_submit(client, payload) != ESP_ERR_NOT_SUPPORTED) {
+                payload = NULL; // event is handled (and payload freed) by the worker
+            } else {
+                dcgw_dispatch(client, payload);
+            }
             break;
         
         default:
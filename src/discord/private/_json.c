@@ -5,6 +5,8 @@
 #include "cutils.h"
 #include "estr.h"
 
+#define DISCORD_PAYLOAD_ARENA_BLOCK_SIZE 512
+
 DISCORD_LOG_DEFINE_BASE();
 
 static struct {
@@ -18,6 +20,7 @@ static struct {
     { "MESSAGE_REACTION_ADD",     DISCORD_EVENT_MESSAGE_REACTION_ADDED },
     { "MESSAGE_REACTION_REMOVE",  DISCORD_EVENT_MESSAGE_REACTION_REMOVED },
     { "VOICE_STATE_UPDATE",       DISCORD_EVENT_VOICE_STATE_UPDATED },
+    { "RESUMED",                  DISCORD_EVENT_RESUMED },
 };
 
 static discord_event_t discord_model_event_by_name(const char* name) {
@@ -32,6 +35,145 @@ static discord_event_t discord_model_event_by_name(const char* name) {
     return DISCORD_EVENT_UNKNOWN;
 }
 
+static const dcjs_field_t discord_user_fields[] = {
+    DCJS_FIELD_ID(discord_user_t, id, "id"),
+    DCJS_FIELD_BOOLEAN(discord_user_t, bot, "bot"),
+    DCJS_FIELD_STR(discord_user_t, username, "username"),
+    DCJS_FIELD_STR(discord_user_t, discriminator, "discriminator"),
+};
+
+const dcjs_schema_t discord_user_schema = DCJS_SCHEMA(discord_user_t, discord_user_fields);
+
+static const dcjs_field_t discord_member_fields[] = {
+    DCJS_FIELD_STR(discord_member_t, nick, "nick"),
+    DCJS_FIELD_STR(discord_member_t, permissions, "permissions"),
+    DCJS_FIELD_ARR_ID(discord_member_t, roles, _roles_len, "roles"),
+};
+
+const dcjs_schema_t discord_member_schema = DCJS_SCHEMA(discord_member_t, discord_member_fields);
+
+static const dcjs_field_t discord_attachment_fields[] = {
+    DCJS_FIELD_ID(discord_attachment_t, id, "id"),
+    DCJS_FIELD_STR(discord_attachment_t, filename, "filename"),
+    DCJS_FIELD_STR(discord_attachment_t, content_type, "content_type"),
+    DCJS_FIELD_NUM(discord_attachment_t, size, "size"),
+    DCJS_FIELD_STR(discord_attachment_t, url, "url"),
+};
+
+const dcjs_schema_t discord_attachment_schema = DCJS_SCHEMA(discord_attachment_t, discord_attachment_fields);
+
+static const dcjs_field_t discord_message_fields[] = {
+    DCJS_FIELD_ID(discord_message_t, id, "id"),
+    DCJS_FIELD_NUM(discord_message_t, type, "type"),
+    DCJS_FIELD_STR(discord_message_t, content, "content"),
+    DCJS_FIELD_ID(discord_message_t, channel_id, "channel_id"),
+    DCJS_FIELD_OBJ(discord_message_t, author, "author", &discord_user_schema),
+    DCJS_FIELD_ID(discord_message_t, guild_id, "guild_id"),
+    DCJS_FIELD_OBJ(discord_message_t, member, "member", &discord_member_schema),
+    DCJS_FIELD_ARR(discord_message_t, attachments, _attachments_len, "attachments", &discord_attachment_schema),
+};
+
+static void discord_message_schema_init(void* obj) {
+    ((discord_message_t*) obj)->type = DISCORD_MESSAGE_UNDEFINED;
+}
+
+const dcjs_schema_t discord_message_schema = DCJS_SCHEMA_(discord_message_t, discord_message_fields, discord_message_schema_init);
+
+static const dcjs_field_t discord_emoji_fields[] = {
+    DCJS_FIELD_STR(discord_emoji_t, name, "name"),
+};
+
+const dcjs_schema_t discord_emoji_schema = DCJS_SCHEMA(discord_emoji_t, discord_emoji_fields);
+
+static const dcjs_field_t discord_message_reaction_fields[] = {
+    DCJS_FIELD_ID(discord_message_reaction_t, user_id, "user_id"),
+    DCJS_FIELD_ID(discord_message_reaction_t, message_id, "message_id"),
+    DCJS_FIELD_ID(discord_message_reaction_t, channel_id, "channel_id"),
+    DCJS_FIELD_OBJ(discord_message_reaction_t, emoji, "emoji", &discord_emoji_schema),
+};
+
+const dcjs_schema_t discord_message_reaction_schema = DCJS_SCHEMA(discord_message_reaction_t, discord_message_reaction_fields);
+
+static const dcjs_field_t discord_voice_state_fields[] = {
+    DCJS_FIELD_ID(discord_voice_state_t, guild_id, "guild_id"),
+    DCJS_FIELD_ID(discord_voice_state_t, channel_id, "channel_id"),
+    DCJS_FIELD_ID(discord_voice_state_t, user_id, "user_id"),
+    DCJS_FIELD_OBJ(discord_voice_state_t, member, "member", &discord_member_schema),
+    DCJS_FIELD_BOOLEAN(discord_voice_state_t, deaf, "deaf"),
+    DCJS_FIELD_BOOLEAN(discord_voice_state_t, mute, "mute"),
+    DCJS_FIELD_BOOLEAN(discord_voice_state_t, self_deaf, "self_deaf"),
+    DCJS_FIELD_BOOLEAN(discord_voice_state_t, self_mute, "self_mute"),
+};
+
+const dcjs_schema_t discord_voice_state_schema = DCJS_SCHEMA(discord_voice_state_t, discord_voice_state_fields);
+
+static const dcjs_field_t discord_session_fields[] = {
+    DCJS_FIELD_STR(discord_session_t, session_id, "session_id"),
+    DCJS_FIELD_STR(discord_session_t, resume_gateway_url, "resume_gateway_url"),
+    DCJS_FIELD_OBJ(discord_session_t, user, "user", &discord_user_schema),
+};
+
+const dcjs_schema_t discord_session_schema = DCJS_SCHEMA(discord_session_t, discord_session_fields);
+
+static const dcjs_field_t discord_guild_fields[] = {
+    DCJS_FIELD_ID(discord_guild_t, id, "id"),
+    DCJS_FIELD_STR(discord_guild_t, name, "name"),
+    DCJS_FIELD_STR(discord_guild_t, permissions, "permissions"),
+};
+
+const dcjs_schema_t discord_guild_schema = DCJS_SCHEMA(discord_guild_t, discord_guild_fields);
+
+static const dcjs_field_t discord_channel_fields[] = {
+    DCJS_FIELD_ID(discord_channel_t, id, "id"),
+    DCJS_FIELD_NUM(discord_channel_t, type, "type"),
+    DCJS_FIELD_STR(discord_channel_t, name, "name"),
+};
+
+const dcjs_schema_t discord_channel_schema = DCJS_SCHEMA(discord_channel_t, discord_channel_fields);
+
+static const dcjs_field_t discord_role_fields[] = {
+    DCJS_FIELD_ID(discord_role_t, id, "id"),
+    DCJS_FIELD_STR(discord_role_t, name, "name"),
+    DCJS_FIELD_NUM(discord_role_t, position, "position"),
+    DCJS_FIELD_STR(discord_role_t, permissions, "permissions"),
+};
+
+const dcjs_schema_t discord_role_schema = DCJS_SCHEMA(discord_role_t, discord_role_fields);
+
+/**
+ * @brief Get schema for direct decoding of dispatch event data.
+ *        Events without schema (or with schema disabled in the config) are decoded via cJSON
+ */
+static const dcjs_schema_t* discord_dispatch_event_schema(discord_event_t e) {
+    switch(e) {
+#ifdef CONFIG_DISCORD_JSON_SCHEMA_SESSION
+        case DISCORD_EVENT_READY:
+            return &discord_session_schema;
+#endif
+
+#ifdef CONFIG_DISCORD_JSON_SCHEMA_MESSAGE
+        case DISCORD_EVENT_MESSAGE_RECEIVED:
+        case DISCORD_EVENT_MESSAGE_UPDATED:
+        case DISCORD_EVENT_MESSAGE_DELETED:
+            return &discord_message_schema;
+#endif
+
+#ifdef CONFIG_DISCORD_JSON_SCHEMA_MESSAGE_REACTION
+        case DISCORD_EVENT_MESSAGE_REACTION_ADDED:
+        case DISCORD_EVENT_MESSAGE_REACTION_REMOVED:
+            return &discord_message_reaction_schema;
+#endif
+
+#ifdef CONFIG_DISCORD_JSON_SCHEMA_VOICE_STATE
+        case DISCORD_EVENT_VOICE_STATE_UPDATED:
+            return &discord_voice_state_schema;
+#endif
+
+        default:
+            return NULL;
+    }
+}
+
 cJSON* discord_payload_to_cjson(discord_payload_t* payload) {
     if(!payload)
         return NULL;
@@ -49,6 +191,14 @@ cJSON* discord_payload_to_cjson(discord_payload_t* payload) {
         case DISCORD_OP_IDENTIFY:
             cJSON_AddItemToObject(root, d, discord_identify_to_cjson((discord_identify_t*) payload->d));
             break;
+
+        case DISCORD_OP_RESUME:
+            cJSON_AddItemToObject(root, d, discord_resume_to_cjson((discord_resume_t*) payload->d));
+            break;
+
+        case DISCORD_OP_PRESENCE_UPDATE: // already serialized (see discord_presence_update)
+            cJSON_AddItemToObject(root, d, cJSON_CreateRaw((const char*) payload->d));
+            break;
         
         default:
             DISCORD_LOGW("Cannot recognize payload type");
@@ -60,6 +210,36 @@ cJSON* discord_payload_to_cjson(discord_payload_t* payload) {
     return root;
 }
 
+/**
+ * @brief Set payload data from cJSON object of "d" member. Payload op (and t) needs to be known already
+ */
+static void discord_payload_data_from_cjson(discord_payload_t* pl, cJSON* d) {
+    switch(pl->op) {
+        case DISCORD_OP_HELLO: {
+                cJSON* interval = cJSON_GetObjectItem(d, "heartbeat_interval");
+                pl->d = cJSON_IsNumber(interval) ? cu_ctor(discord_hello_t, .heartbeat_interval = interval->valueint) : NULL;
+            }
+            break;
+
+        case DISCORD_OP_DISPATCH:
+            pl->d = discord_dispatch_event_data_from_cjson(pl->t, d);
+            break;
+
+        case DISCORD_OP_INVALID_SESSION:
+            pl->d = cu_ctor(discord_invalid_session_t, .resumable = cJSON_IsTrue(d));
+            break;
+
+        case DISCORD_OP_HEARTBEAT_ACK:
+        case DISCORD_OP_RECONNECT:
+            // Ignore
+            break;
+        
+        default:
+            DISCORD_LOGW("Cannot recognize payload type. Unable to set payload data.");
+            break;
+    }
+}
+
 discord_payload_t* discord_payload_from_cjson(cJSON* cjson) {
     discord_payload_t* pl = cu_ctor(discord_payload_t,
         .op = cJSON_GetObjectItem(cjson, "op")->valueint
@@ -75,30 +255,373 @@ discord_payload_t* discord_payload_from_cjson(cJSON* cjson) {
         pl->s = DISCORD_NULL_SEQUENCE_NUMBER;
     }
 
-    cJSON* d = cJSON_GetObjectItem(cjson, "d");
+    if(pl->op == DISCORD_OP_DISPATCH) {
+        pl->t = discord_model_event_by_name(cJSON_GetObjectItem(cjson, "t")->valuestring);
+    }
 
-    switch(pl->op) {
-        case DISCORD_OP_HELLO:
-            pl->d = cu_ctor(discord_hello_t, .heartbeat_interval = cJSON_GetObjectItem(d, "heartbeat_interval")->valueint);
-            break;
+    discord_payload_data_from_cjson(pl, cJSON_GetObjectItem(cjson, "d"));
 
-        case DISCORD_OP_DISPATCH:
-            pl->t = discord_model_event_by_name(cJSON_GetObjectItem(cjson, "t")->valuestring);
-            pl->d = discord_dispatch_event_data_from_cjson(pl->t, d);
-            break;
+    return pl;
+}
 
-        case DISCORD_OP_HEARTBEAT_ACK:
-            // Ignore
-            break;
-        
-        default:
-            DISCORD_LOGW("Cannot recognize payload type. Unable to set payload data.");
-            break;
+/**
+ * @brief Streaming payload decoder. Envelope (op, s, t) is parsed directly from the parser events.
+ *        Data ("d" member) of the dispatch event which has schema is decoded directly into the model,
+ *        otherwise it's built as cJSON tree. Whole payload never needs to be in one buffer
+ */
+struct discord_payload_decoder {
+    dcjs_parser_handle_t parser;
+    int op;
+    int s;
+    discord_event_t t;
+    bool has_t;
+    discord_payload_decoder_filter_t filter;
+    void* filter_arg;
+    bool in_d;                         /*<! Currently parsed member of the root object is "d" */
+    bool d_skip;                       /*<! Data of the event is not needed, so "d" is not decoded */
+    bool d_schema;                     /*<! "d" is decoded by the schema decoder */
+    dcjs_decoder_t model;
+    earena_handle_t arena;             /*<! Arena of the decoded model */
+    cJSON* d;
+    cJSON* stack[DCJS_MAX_DEPTH];      /*<! Containers of "d" by the depth */
+};
+
+static cJSON* discord_payload_decoder_create_item(const dcjs_event_t* event) {
+    switch(event->type) {
+        case DCJS_EVENT_OBJECT_START: return cJSON_CreateObject();
+        case DCJS_EVENT_ARRAY_START:  return cJSON_CreateArray();
+        case DCJS_EVENT_STRING:       return cJSON_CreateString(event->value);
+        case DCJS_EVENT_NUMBER:       return cJSON_CreateNumber(strtod(event->value, NULL));
+        case DCJS_EVENT_TRUE:         return cJSON_CreateTrue();
+        case DCJS_EVENT_FALSE:        return cJSON_CreateFalse();
+        case DCJS_EVENT_NULL:         return cJSON_CreateNull();
+        default:                      return NULL;
+    }
+}
+
+static esp_err_t discord_payload_decoder_handler(const dcjs_event_t* event, void* arg) {
+    struct discord_payload_decoder* decoder = (struct discord_payload_decoder*) arg;
+
+    if(event->depth == 0) { // payload needs to be an object
+        return event->type == DCJS_EVENT_OBJECT_START || event->type == DCJS_EVENT_OBJECT_END ? ESP_OK : ESP_FAIL;
+    }
+
+    if(event->depth == 1 && !(decoder->in_d = estr_eq(event->key, "d"))) {
+        if(event->type == DCJS_EVENT_NUMBER) {
+            if(estr_eq(event->key, "op")) {
+                decoder->op = atoi(event->value);
+            } else if(estr_eq(event->key, "s")) {
+                decoder->s = atoi(event->value);
+            }
+        } else if(event->type == DCJS_EVENT_STRING && estr_eq(event->key, "t")) {
+            decoder->t = discord_model_event_by_name(event->value);
+            decoder->has_t = true;
+        }
+
+        return ESP_OK;
+    }
+
+    if(!decoder->in_d) {
+        return ESP_OK;
+    }
+
+    if(event->depth == 1) {
+        // "t" usually comes before "d", so data of the unwanted event can be skipped without decoding
+        decoder->d_skip = decoder->has_t && (decoder->t == DISCORD_EVENT_UNKNOWN
+            || (decoder->filter && !decoder->filter(decoder->t, decoder->filter_arg)));
+    }
+
+    if(decoder->d_skip) {
+        return ESP_OK;
     }
 
+    if(event->depth == 1) {
+        const dcjs_schema_t* schema = discord_dispatch_event_schema(decoder->t);
+
+        if(decoder->d_schema) { // duplicated member
+            dcjs_decoder_abort(&decoder->model);
+        }
+
+        if((decoder->d_schema = schema != NULL)) {
+            // session (READY) is detached from the payload and it lives until the end of the session, so it cannot be in the arena
+            if(decoder->t != DISCORD_EVENT_READY && !decoder->arena) {
+                decoder->arena = earena_create(DISCORD_PAYLOAD_ARENA_BLOCK_SIZE); // fallback to heap if it fails
+            }
+
+            dcjs_decoder_begin(&decoder->model, schema, 1, decoder->arena);
+        }
+    }
+
+    if(decoder->d_schema) {
+        return dcjs_decoder_handle(&decoder->model, event);
+    }
+
+    if(event->type == DCJS_EVENT_OBJECT_END || event->type == DCJS_EVENT_ARRAY_END) {
+        return ESP_OK;
+    }
+
+    cJSON* item = discord_payload_decoder_create_item(event);
+
+    if(!item) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if(event->depth == 1) {
+        cJSON_Delete(decoder->d); // in case of duplicated member
+        decoder->d = item;
+    } else {
+        cJSON* parent = decoder->stack[event->depth - 1];
+
+        if(cJSON_IsArray(parent)) {
+            cJSON_AddItemToArray(parent, item);
+        } else {
+            cJSON_AddItemToObject(parent, event->key, item);
+        }
+    }
+
+    if(event->type == DCJS_EVENT_OBJECT_START || event->type == DCJS_EVENT_ARRAY_START) {
+        decoder->stack[event->depth] = item;
+    }
+
+    return ESP_OK;
+}
+
+discord_payload_decoder_handle_t discord_payload_decoder_create(size_t max_token_len, discord_payload_decoder_filter_t filter, void* filter_arg) {
+    discord_payload_decoder_handle_t decoder = calloc(1, sizeof(struct discord_payload_decoder));
+
+    if(!decoder) {
+        return NULL;
+    }
+
+    decoder->filter = filter;
+    decoder->filter_arg = filter_arg;
+
+    if(!(decoder->parser = dcjs_create(max_token_len, discord_payload_decoder_handler, decoder))) {
+        free(decoder);
+        return NULL;
+    }
+
+    discord_payload_decoder_reset(decoder);
+
+    return decoder;
+}
+
+esp_err_t discord_payload_decoder_feed(discord_payload_decoder_handle_t decoder, const char* data, size_t len) {
+    if(!decoder) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return dcjs_feed(decoder->parser, data, len);
+}
+
+discord_payload_t* discord_payload_decoder_finish(discord_payload_decoder_handle_t decoder) {
+    if(!decoder) {
+        return NULL;
+    }
+
+    discord_payload_t* pl = NULL;
+    esp_err_t err = dcjs_finish(decoder->parser);
+
+    if(err == ESP_ERR_INVALID_SIZE) {
+        DISCORD_LOGW("Payload token too big. Wider buffer required.");
+    } else if(err != ESP_OK) {
+        DISCORD_LOGW("JSON parsing (syntax?) error");
+    } else if(decoder->op < 0) {
+        DISCORD_LOGW("Payload without op code");
+    } else {
+        pl = cu_ctor(discord_payload_t,
+            .op = decoder->op,
+            .s = decoder->s > 0 ? decoder->s : DISCORD_NULL_SEQUENCE_NUMBER
+        );
+
+        // todo: memcheck
+
+        if(pl->op == DISCORD_OP_DISPATCH) {
+            pl->t = decoder->t;
+        }
+
+        if(decoder->d_skip) {
+            DISCORD_LOGD("Data of event %d is skipped", pl->t);
+        } else if(decoder->d_schema) {
+            pl->d = dcjs_decoder_end(&decoder->model);
+
+            if(pl->d && decoder->model.arena) {
+                pl->_arena = decoder->arena;
+                decoder->arena = NULL;
+            }
+        } else {
+            discord_payload_data_from_cjson(pl, decoder->d);
+        }
+    }
+
+    discord_payload_decoder_reset(decoder);
+
     return pl;
 }
 
+void discord_payload_decoder_reset(discord_payload_decoder_handle_t decoder) {
+    if(!decoder)
+        return;
+
+    dcjs_reset(decoder->parser);
+    cJSON_Delete(decoder->d);
+    decoder->d = NULL;
+
+    if(decoder->d_schema) {
+        dcjs_decoder_abort(&decoder->model);
+    }
+
+    earena_destroy(decoder->arena);
+    decoder->arena = NULL;
+    decoder->op = -1;
+    decoder->s = DISCORD_NULL_SEQUENCE_NUMBER;
+    decoder->t = DISCORD_EVENT_UNKNOWN;
+    decoder->has_t = false;
+    decoder->in_d = false;
+    decoder->d_skip = false;
+    decoder->d_schema = false;
+}
+
+void discord_payload_decoder_destroy(discord_payload_decoder_handle_t decoder) {
+    if(!decoder)
+        return;
+
+    discord_payload_decoder_reset(decoder);
+    dcjs_destroy(decoder->parser);
+    free(decoder);
+}
+
+struct discord_list_decoder {
+    dcjs_parser_handle_t parser;
+    dcjs_decoder_t model;
+    bool in_item;                                  /*<! Item (object of the top-level array) is being decoded */
+    discord_list_visitor_t visitor;
+    void* visitor_arg;
+    bool stopped;                                  /*<! Visitor stopped the decoding */
+    void** list;
+    int len;
+};
+
+static esp_err_t discord_list_decoder_handler(const dcjs_event_t* event, void* arg) {
+    discord_list_decoder_handle_t decoder = (discord_list_decoder_handle_t) arg;
+
+    if(decoder->stopped) {
+        return ESP_OK; // ignore the rest of the chunk, visitor stopped the iteration
+    }
+
+    if(event->depth == 0) {
+        return event->type == DCJS_EVENT_ARRAY_START || event->type == DCJS_EVENT_ARRAY_END ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+    }
+
+    esp_err_t err;
+
+    if((err = dcjs_decoder_handle(&decoder->model, event)) != ESP_OK) {
+        return err;
+    }
+
+    if(event->depth == 1) {
+        if(event->type == DCJS_EVENT_OBJECT_START) {
+            decoder->in_item = true;
+        } else if(event->type == DCJS_EVENT_OBJECT_END && decoder->in_item) {
+            decoder->in_item = false;
+
+            if(decoder->visitor) {
+                void* item = dcjs_decoder_end(&decoder->model);
+                decoder->stopped = !decoder->visitor(item, decoder->visitor_arg);
+                dcjs_schema_free(decoder->model.schema, item);
+
+                return ESP_OK;
+            }
+
+            if((decoder->len & (decoder->len - 1)) == 0) { // grow at powers of two
+                void** _list = realloc(decoder->list, (decoder->len > 0 ? decoder->len * 2 : 1) * sizeof(void*));
+
+                if(!_list) {
+                    return ESP_ERR_NO_MEM;
+                }
+
+                decoder->list = _list;
+            }
+
+            decoder->list[decoder->len++] = dcjs_decoder_end(&decoder->model);
+        }
+    }
+
+    return ESP_OK;
+}
+
+discord_list_decoder_handle_t discord_list_decoder_create(const dcjs_schema_t* schema, size_t max_token_len, discord_list_visitor_t visitor, void* visitor_arg) {
+    discord_list_decoder_handle_t decoder = calloc(1, sizeof(struct discord_list_decoder));
+
+    if(!decoder) {
+        return NULL;
+    }
+
+    decoder->visitor = visitor;
+    decoder->visitor_arg = visitor_arg;
+
+    if(!(decoder->parser = dcjs_create(max_token_len, discord_list_decoder_handler, decoder))) {
+        free(decoder);
+        return NULL;
+    }
+
+    dcjs_decoder_begin(&decoder->model, schema, 1, NULL);
+
+    return decoder;
+}
+
+esp_err_t discord_list_decoder_feed(discord_list_decoder_handle_t decoder, const char* data, size_t len) {
+    if(!decoder) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(decoder->stopped) {
+        return ESP_OK; // ignore the rest of the list
+    }
+
+    return dcjs_feed(decoder->parser, data, len);
+}
+
+esp_err_t discord_list_decoder_finish(discord_list_decoder_handle_t decoder, void*** out_list, int* out_len) {
+    if(!decoder) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = decoder->stopped ? ESP_OK : dcjs_finish(decoder->parser);
+
+    if(err == ESP_ERR_INVALID_SIZE) {
+        DISCORD_LOGW("Token too big. Wider buffer required.");
+        return err;
+    } else if(err != ESP_OK) {
+        DISCORD_LOGW("JSON parsing (syntax?) error");
+        return err;
+    }
+
+    if(out_list && out_len) {
+        *out_list = decoder->list;
+        *out_len = decoder->len;
+        decoder->list = NULL;
+        decoder->len = 0;
+    }
+
+    return ESP_OK;
+}
+
+void discord_list_decoder_destroy(discord_list_decoder_handle_t decoder) {
+    if(!decoder)
+        return;
+
+    dcjs_decoder_abort(&decoder->model);
+
+    for(int i = 0; i < decoder->len; i++) {
+        dcjs_schema_free(decoder->model.schema, decoder->list[i]);
+    }
+
+    free(decoder->list);
+    dcjs_destroy(decoder->parser);
+    free(decoder);
+}
+
 discord_payload_data_t discord_dispatch_event_data_from_cjson(discord_event_t e, cJSON* cjson) {
     switch (e) {
         case DISCORD_EVENT_READY:
@@ -116,12 +639,30 @@ discord_payload_data_t discord_dispatch_event_data_from_cjson(discord_event_t e,
         case DISCORD_EVENT_VOICE_STATE_UPDATED:
             return discord_voice_state_from_cjson(cjson);
 
+        case DISCORD_EVENT_RESUMED:
+            return NULL;
+
         default:
             DISCORD_LOGW("Cannot recognize event type");
             return NULL;
     }
 }
 
+/**
+ * @brief Parse snowflake from the string item
+ * @return Snowflake or DISCORD_SNOWFLAKE_NULL if item is missing (or it is not a string)
+ */
+static discord_snowflake_t discord_snowflake_from_cjson(cJSON* item) {
+    return cJSON_IsString(item) ? discord_snowflake_from_str(item->valuestring) : DISCORD_SNOWFLAKE_NULL;
+}
+
+/**
+ * @brief Create string item from the snowflake
+ */
+static cJSON* discord_snowflake_to_cjson(discord_snowflake_t snowflake) {
+    return cJSON_CreateString(DISCORD_SNOWFLAKE_STR(snowflake));
+}
+
 cJSON* discord_heartbeat_to_cjson(discord_heartbeat_t* heartbeat) {
     int hb = *((int*) (heartbeat));
 
@@ -148,17 +689,103 @@ cJSON* discord_identify_to_cjson(discord_identify_t* identify) {
     cJSON_AddNumberToObject(root, "intents", identify->intents);
     cJSON_AddItemToObject(root, "properties", discord_identify_properties_to_cjson(identify->properties));
 
+    if(identify->shard_count > 0) {
+        cJSON_AddItemToObject(root, "shard", cJSON_CreateIntArray((const int[]) { identify->shard_id, identify->shard_count }, 2));
+    }
+
+    return root;
+}
+
+cJSON* discord_resume_to_cjson(discord_resume_t* resume) {
+    cJSON* root = cJSON_CreateObject();
+
+    // todo: memchecks
+    cJSON_AddItemToObject(root, "token", cJSON_CreateStringReference(resume->token));
+    cJSON_AddItemToObject(root, "session_id", cJSON_CreateStringReference(resume->session_id));
+    cJSON_AddNumberToObject(root, "seq", resume->seq);
+
+    return root;
+}
+
+static const char* discord_presence_status_str(discord_presence_status_t status) {
+    switch(status) {
+        case DISCORD_PRESENCE_DND: return "dnd";
+        case DISCORD_PRESENCE_IDLE: return "idle";
+        case DISCORD_PRESENCE_INVISIBLE: return "invisible";
+        default: return "online";
+    }
+}
+
+cJSON* discord_presence_to_cjson(discord_presence_t* presence) {
+    cJSON* root = cJSON_CreateObject();
+    cJSON* activities = cJSON_CreateArray();
+
+    // todo: memchecks
+    cJSON_AddItemToObject(root, "since", cJSON_CreateNull());
+
+    if(presence->activity) {
+        discord_activity_t* activity = presence->activity;
+        cJSON* _activity = cJSON_CreateObject();
+
+        cJSON_AddItemToObject(_activity, "name", cJSON_CreateStringReference(activity->name ? activity->name : "Custom Status"));
+        cJSON_AddNumberToObject(_activity, "type", activity->type);
+
+        if(activity->state) {
+            cJSON_AddItemToObject(_activity, "state", cJSON_CreateStringReference(activity->state));
+        }
+
+        cJSON_AddItemToArray(activities, _activity);
+    }
+
+    cJSON_AddItemToObject(root, "activities", activities);
+    cJSON_AddItemToObject(root, "status", cJSON_CreateStringReference(discord_presence_status_str(presence->status)));
+    cJSON_AddBoolToObject(root, "afk", presence->afk);
+
     return root;
 }
 
+static int discord_cjson_get_int(cJSON* root, const char* key) {
+    cJSON* item = cJSON_GetObjectItem(root, key);
+    return cJSON_IsNumber(item) ? item->valueint : 0;
+}
+
+discord_gateway_bot_t* discord_gateway_bot_from_cjson(cJSON* root) {
+    if(!root)
+        return NULL;
+
+    cJSON* _url = cJSON_GetObjectItem(root, "url");
+    cJSON* _limit = cJSON_GetObjectItem(root, "session_start_limit");
+
+    if(!cJSON_IsString(_url) || !cJSON_IsObject(_limit)) {
+        return NULL;
+    }
+
+    discord_gateway_bot_t* gateway_bot = cu_ctor(discord_gateway_bot_t,
+        .url = _url->valuestring,
+        .shards = discord_cjson_get_int(root, "shards"),
+        .total = discord_cjson_get_int(_limit, "total"),
+        .remaining = discord_cjson_get_int(_limit, "remaining"),
+        .reset_after = discord_cjson_get_int(_limit, "reset_after"),
+        .max_concurrency = discord_cjson_get_int(_limit, "max_concurrency")
+    );
+
+    // todo: memcheck
+
+    _url->valuestring = NULL;
+
+    return gateway_bot;
+}
+
 discord_session_t* discord_session_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
 
     cJSON* _id = cJSON_GetObjectItem(root, "session_id");
+    cJSON* _resume_url = cJSON_GetObjectItem(root, "resume_gateway_url");
 
     discord_session_t* session = cu_ctor(discord_session_t,
         .session_id = _id->valuestring,
+        .resume_gateway_url = _resume_url ? _resume_url->valuestring : NULL,
         .user = discord_user_from_cjson(cJSON_GetObjectItem(root, "user"))
     );
 
@@ -166,6 +793,8 @@ discord_session_t* discord_session_from_cjson(cJSON* root) {
 
     _id->valuestring = NULL;
 
+    if(_resume_url) { _resume_url->valuestring = NULL; }
+
     return session;
 }
 
@@ -173,13 +802,12 @@ discord_user_t* discord_user_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
 
-    cJSON* _id = cJSON_GetObjectItem(root, "id");
     cJSON* _bot = cJSON_GetObjectItem(root, "bot");
     cJSON* _username = cJSON_GetObjectItem(root, "username");
     cJSON* _discriminator = cJSON_GetObjectItem(root, "discriminator");
 
     discord_user_t* user = cu_ctor(discord_user_t,
-        .id = _id->valuestring,
+        .id = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "id")),
         .bot = _bot && _bot->valueint,
         .username = _username->valuestring,
         .discriminator = _discriminator->valuestring
@@ -187,7 +815,6 @@ discord_user_t* discord_user_from_cjson(cJSON* root) {
 
     // todo: memcheck
 
-    _id->valuestring =
     _username->valuestring =
     _discriminator->valuestring =
     NULL;
@@ -198,7 +825,7 @@ discord_user_t* discord_user_from_cjson(cJSON* root) {
 cJSON* discord_user_to_cjson(discord_user_t* user) {
     cJSON* root = cJSON_CreateObject();
 
-    cJSON_AddItemToObject(root, "id", cJSON_CreateStringReference(user->id));
+    cJSON_AddItemToObject(root, "id", discord_snowflake_to_cjson(user->id));
     cJSON_AddItemToObject(root, "username", cJSON_CreateStringReference(user->username));
     cJSON_AddItemToObject(root, "discriminator", cJSON_CreateStringReference(user->discriminator));
     cJSON_AddBoolToObject(root, "bot", user->bot);
@@ -228,14 +855,12 @@ discord_member_t* discord_member_from_cjson(cJSON* root) {
     cJSON* _roles = cJSON_GetObjectItem(root, "roles");
 
     if(cJSON_IsArray(_roles) && ((member->_roles_len = cJSON_GetArraySize(_roles)) > 0)) {
-        member->roles = calloc(member->_roles_len, sizeof(char*));
+        member->roles = calloc(member->_roles_len, sizeof(discord_snowflake_t));
 
         // todo: memcheck
 
         for(discord_role_len_t i = 0; i < member->_roles_len; i++) {
-            cJSON* _role = cJSON_GetArrayItem(_roles, i);
-            member->roles[i] = _role->valuestring;
-            _role->valuestring = NULL;
+            member->roles[i] = discord_snowflake_from_cjson(cJSON_GetArrayItem(_roles, i));
         }
     }
 
@@ -260,13 +885,12 @@ discord_attachment_t* discord_attachment_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
 
-    cJSON* _id = cJSON_GetObjectItem(root, "id");
     cJSON* _fname = cJSON_GetObjectItem(root, "filename");
     cJSON* _ctype = cJSON_GetObjectItem(root, "content_type");
     cJSON* _url = cJSON_GetObjectItem(root, "url");
 
     discord_attachment_t* attachment = cu_ctor(discord_attachment_t,
-        .id = _id->valuestring,
+        .id = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "id")),
         .filename = _fname->valuestring,
         .content_type = _ctype ? _ctype->valuestring : NULL,
         .size = cJSON_GetObjectItem(root, "size")->valueint,
@@ -275,7 +899,6 @@ discord_attachment_t* discord_attachment_from_cjson(cJSON* root) {
 
     // todo: memcheck
 
-    _id->valuestring =
     _fname->valuestring =
     _url->valuestring =
     NULL;
@@ -291,7 +914,7 @@ cJSON* discord_attachment_to_cjson(discord_attachment_t* attachment) {
     
     cJSON* root = cJSON_CreateObject();
 
-    if(attachment->id) cJSON_AddItemToObject(root, "id", cJSON_CreateStringReference(attachment->id));
+    cJSON_AddItemToObject(root, "id", cJSON_CreateNumber(attachment->id));
     if(attachment->filename) cJSON_AddItemToObject(root, "filename", cJSON_CreateStringReference(attachment->filename));
 
     // todo: memchecks
@@ -385,19 +1008,18 @@ discord_guild_t* discord_guild_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
 
-    cJSON* _id = cJSON_GetObjectItem(root, "id");
     cJSON* _name = cJSON_GetObjectItem(root, "name");
     cJSON* _permissions = cJSON_GetObjectItem(root, "permissions");
 
     discord_guild_t* guild = cu_ctor(discord_guild_t,
-        .id = _id->valuestring,
+        .id = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "id")),
         .name = _name->valuestring,
         .permissions = _permissions == NULL ? NULL : _permissions->valuestring
     );
 
     // todo: memcheck
 
-    _id->valuestring = _name->valuestring = NULL;
+    _name->valuestring = NULL;
 
     if(_permissions) {
         _permissions->valuestring = NULL;
@@ -412,7 +1034,7 @@ cJSON* discord_guild_to_cjson(discord_guild_t* guild) {
     
     cJSON* root = cJSON_CreateObject();
 
-    cJSON_AddItemToObject(root, "id", cJSON_CreateStringReference(guild->id));
+    cJSON_AddItemToObject(root, "id", discord_snowflake_to_cjson(guild->id));
     cJSON_AddItemToObject(root, "name", cJSON_CreateStringReference(guild->name));
     
     if(guild->permissions) {
@@ -428,20 +1050,17 @@ discord_channel_t* discord_channel_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
 
-    cJSON* _id = cJSON_GetObjectItem(root, "id");
     cJSON* _type = cJSON_GetObjectItem(root, "type");
     cJSON* _name = cJSON_GetObjectItem(root, "name");
 
     discord_channel_t* channel = cu_ctor(discord_channel_t,
-        .id = _id->valuestring,
+        .id = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "id")),
         .type = (discord_channel_type_t) _type->valueint,
         .name = _name == NULL ? NULL : _name->valuestring,
     );
 
     // todo: memcheck
 
-    _id->valuestring = NULL;
-
     if(_name) {
         _name->valuestring = NULL;
     }
@@ -455,7 +1074,7 @@ cJSON* discord_channel_to_cjson(discord_channel_t* channel) {
     
     cJSON* root = cJSON_CreateObject();
 
-    cJSON_AddItemToObject(root, "id", cJSON_CreateStringReference(channel->id));
+    cJSON_AddItemToObject(root, "id", discord_snowflake_to_cjson(channel->id));
     cJSON_AddItemToObject(root, "type", cJSON_CreateNumber(channel->type));
     
     if(channel->name) {
@@ -471,13 +1090,12 @@ discord_role_t* discord_role_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
 
-    cJSON* _id = cJSON_GetObjectItem(root, "id");
     cJSON* _name = cJSON_GetObjectItem(root, "name");
     cJSON* _pos = cJSON_GetObjectItem(root, "position");
     cJSON* _permissions = cJSON_GetObjectItem(root, "permissions");
 
     discord_role_t* role = cu_ctor(discord_role_t,
-        .id = _id->valuestring,
+        .id = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "id")),
         .name = _name->valuestring,
         .position = _pos->valueint,
         .permissions = _permissions->valuestring
@@ -485,7 +1103,6 @@ discord_role_t* discord_role_from_cjson(cJSON* root) {
 
     // todo: memcheck
 
-    _id->valuestring =
     _name->valuestring =
     _permissions->valuestring =
     NULL;
@@ -499,7 +1116,7 @@ cJSON* discord_role_to_cjson(discord_role_t* role) {
     
     cJSON* root = cJSON_CreateObject();
 
-    if(role->id) cJSON_AddItemToObject(root, "id", cJSON_CreateStringReference(role->id));
+    if(role->id) cJSON_AddItemToObject(root, "id", discord_snowflake_to_cjson(role->id));
     cJSON_AddItemToObject(root, "name", cJSON_CreateStringReference(role->name));
     cJSON_AddNumberToObject(root, "position", role->position);
     cJSON_AddItemToObject(root, "permissions", cJSON_CreateStringReference(role->permissions));
@@ -513,29 +1130,22 @@ discord_message_t* discord_message_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
 
-    cJSON* _id = cJSON_GetObjectItem(root, "id");
     cJSON* _content = cJSON_GetObjectItem(root, "content");
-    cJSON* _cid = cJSON_GetObjectItem(root, "channel_id");
-    cJSON* _gid = cJSON_GetObjectItem(root, "guild_id");
     cJSON* _type = cJSON_GetObjectItem(root, "type");
 
     discord_message_t* message = cu_ctor(discord_message_t,
-        .id = _id ? _id->valuestring : NULL,
+        .id = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "id")),
         .type = (discord_message_type_t) (_type ? _type->valueint : DISCORD_MESSAGE_UNDEFINED),
         .content = _content ? _content->valuestring : NULL,
-        .channel_id = _cid->valuestring,
+        .channel_id = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "channel_id")),
         .author = discord_user_from_cjson(cJSON_GetObjectItem(root, "author")),
-        .guild_id = _gid ? _gid->valuestring : NULL,
+        .guild_id = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "guild_id")),
         .member = discord_member_from_cjson(cJSON_GetObjectItem(root, "member"))
     );
 
     // todo: memchecks
 
-    _cid->valuestring = NULL;
-
     if(_content) _content->valuestring = NULL;
-    if(_id) _id->valuestring = NULL;
-    if(_gid) _gid->valuestring = NULL;
 
     cJSON* _attachments = cJSON_GetObjectItem(root, "attachments");
 
@@ -555,11 +1165,11 @@ discord_message_t* discord_message_from_cjson(cJSON* root) {
 cJSON* discord_message_to_cjson(discord_message_t* msg) {
     cJSON* root = cJSON_CreateObject();
 
-    if(msg->id) cJSON_AddItemToObject(root, "id", cJSON_CreateStringReference(msg->id));
+    if(msg->id) cJSON_AddItemToObject(root, "id", discord_snowflake_to_cjson(msg->id));
     cJSON_AddItemToObject(root, "content", cJSON_CreateStringReference(msg->content));
-    cJSON_AddItemToObject(root, "channel_id", cJSON_CreateStringReference(msg->channel_id));
+    cJSON_AddItemToObject(root, "channel_id", discord_snowflake_to_cjson(msg->channel_id));
     if(msg->author) cJSON_AddItemToObject(root, "author", discord_user_to_cjson(msg->author));
-    if(msg->guild_id) cJSON_AddItemToObject(root, "guild_id", cJSON_CreateStringReference(msg->guild_id));
+    if(msg->guild_id) cJSON_AddItemToObject(root, "guild_id", discord_snowflake_to_cjson(msg->guild_id));
     if(msg->member) cJSON_AddItemToObject(root, "member", discord_member_to_cjson(msg->member));
 
     if(msg->_attachments_len > 0 && msg->attachments) {
@@ -611,24 +1221,15 @@ discord_message_reaction_t* discord_message_reaction_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
 
-    cJSON* _uid = cJSON_GetObjectItem(root, "user_id");
-    cJSON* _mid = cJSON_GetObjectItem(root, "message_id");
-    cJSON* _cid = cJSON_GetObjectItem(root, "channel_id");
-
     discord_message_reaction_t* react = cu_ctor(discord_message_reaction_t,
-        .user_id = _uid->valuestring,
-        .message_id = _mid->valuestring,
-        .channel_id = _cid->valuestring,
+        .user_id = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "user_id")),
+        .message_id = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "message_id")),
+        .channel_id = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "channel_id")),
         .emoji = discord_emoji_from_cjson(cJSON_GetObjectItem(root, "emoji"))
     );
 
     // todo: memcheck
 
-    _uid->valuestring =
-    _mid->valuestring =
-    _cid->valuestring =
-    NULL;
-
     return react;
 }
 
@@ -636,15 +1237,12 @@ discord_voice_state_t* discord_voice_state_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
 
-    cJSON* _gid = cJSON_GetObjectItem(root, "guild_id");
-    cJSON* _cid = cJSON_GetObjectItem(root, "channel_id");
-    cJSON* _uid = cJSON_GetObjectItem(root, "user_id");
     cJSON* _member = cJSON_GetObjectItem(root, "member");
 
     discord_voice_state_t* state = cu_ctor(discord_voice_state_t,
-        .guild_id    = _gid->valuestring,
-        .channel_id  = _cid ? _cid->valuestring : NULL,
-        .user_id     = _uid->valuestring,
+        .guild_id    = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "guild_id")),
+        .channel_id  = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "channel_id")),
+        .user_id     = discord_snowflake_from_cjson(cJSON_GetObjectItem(root, "user_id")),
         .member      = discord_member_from_cjson(_member),
         .deaf        = (bool) cJSON_GetObjectItem(root, "deaf")->valueint,
         .mute        = (bool) cJSON_GetObjectItem(root, "mute")->valueint,
@@ -654,11 +1252,5 @@ discord_voice_state_t* discord_voice_state_from_cjson(cJSON* root) {
 
     // todo: memcheck
 
-    _gid->valuestring =
-    _uid->valuestring =
-    NULL;
-
-    if(_cid) { _cid->valuestring = NULL; }
-
     return state;
 }
\ No newline at end of file
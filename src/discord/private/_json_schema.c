@@ -0,0 +1,339 @@
+#include "discord/private/_json_schema.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define _dcjs_field_ptr(obj, offset) ((void*) ((uint8_t*) (obj) + (offset)))
+
+static void* dcjs_decoder_calloc(dcjs_decoder_t* decoder, size_t size) {
+    return decoder->arena ? earena_calloc(decoder->arena, size) : calloc(1, size);
+}
+
+static char* dcjs_decoder_strdup(dcjs_decoder_t* decoder, const dcjs_event_t* event) {
+    return decoder->arena ? earena_strndup(decoder->arena, event->value, event->value_len) : strdup(event->value);
+}
+
+static void dcjs_decoder_free(dcjs_decoder_t* decoder, void* ptr) {
+    if(!decoder->arena) {
+        free(ptr);
+    }
+}
+
+static void* dcjs_schema_alloc(dcjs_decoder_t* decoder, const dcjs_schema_t* schema) {
+    void* obj = dcjs_decoder_calloc(decoder, schema->size);
+
+    if(obj && schema->init) {
+        schema->init(obj);
+    }
+
+    return obj;
+}
+
+static const dcjs_field_t* dcjs_schema_get_field(const dcjs_schema_t* schema, const char* key) {
+    if(!key)
+        return NULL;
+
+    for(uint8_t i = 0; i < schema->fields_len; i++) {
+        if(strcmp(schema->fields[i].key, key) == 0) {
+            return &schema->fields[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void dcjs_write_int(void* ptr, uint8_t size, long long value) {
+    switch(size) {
+        case 1: *((int8_t*) ptr) = (int8_t) value; break;
+        case 2: *((int16_t*) ptr) = (int16_t) value; break;
+        case 4: *((int32_t*) ptr) = (int32_t) value; break;
+        case 8: *((int64_t*) ptr) = (int64_t) value; break;
+        default: break;
+    }
+}
+
+static size_t dcjs_read_len(const void* ptr, uint8_t size) {
+    switch(size) {
+        case 1: return *((const uint8_t*) ptr);
+        case 2: return *((const uint16_t*) ptr);
+        case 4: return *((const uint32_t*) ptr);
+        case 8: return (size_t) *((const uint64_t*) ptr);
+        default: return 0;
+    }
+}
+
+static size_t dcjs_max_len(uint8_t size) {
+    return size >= sizeof(size_t) ? SIZE_MAX : ((size_t) 1 << (size * 8)) - 1;
+}
+
+static void dcjs_field_free(const dcjs_field_t* field, void* obj) {
+    void** ptr = (void**) _dcjs_field_ptr(obj, field->offset);
+
+    switch(field->type) {
+        case DCJS_FIELD_STRING:
+            free(*ptr);
+            *ptr = NULL;
+            break;
+
+        case DCJS_FIELD_OBJECT:
+            dcjs_schema_free(field->schema, *ptr);
+            *ptr = NULL;
+            break;
+
+        case DCJS_FIELD_ARRAY: {
+                void* len_ptr = _dcjs_field_ptr(obj, field->len_offset);
+                size_t len = dcjs_read_len(len_ptr, field->len_size);
+                void** arr = (void**) *ptr;
+
+                for(size_t i = 0; arr && field->element != DCJS_FIELD_SNOWFLAKE && i < len; i++) {
+                    if(field->element == DCJS_FIELD_OBJECT) {
+                        dcjs_schema_free(field->schema, arr[i]);
+                    } else {
+                        free(arr[i]);
+                    }
+                }
+
+                free(arr);
+                *ptr = NULL;
+                dcjs_write_int(len_ptr, field->len_size, 0);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Release the current value of the field (if it's not allocated from the arena) and reset it
+ */
+static void dcjs_decoder_field_reset(dcjs_decoder_t* decoder, const dcjs_field_t* field, void* obj) {
+    if(!decoder->arena) {
+        dcjs_field_free(field, obj);
+        return;
+    }
+
+    *((void**) _dcjs_field_ptr(obj, field->offset)) = NULL;
+
+    if(field->type == DCJS_FIELD_ARRAY) {
+        dcjs_write_int(_dcjs_field_ptr(obj, field->len_offset), field->len_size, 0);
+    }
+}
+
+/**
+ * @brief Append element to array field. Array capacity is doubled when length reaches the power of two
+ */
+static esp_err_t dcjs_array_append(dcjs_decoder_t* decoder, const dcjs_field_t* field, void* owner, const void* element) {
+    uint8_t** arr = (uint8_t**) _dcjs_field_ptr(owner, field->offset);
+    void* len_ptr = _dcjs_field_ptr(owner, field->len_offset);
+    size_t len = dcjs_read_len(len_ptr, field->len_size);
+    size_t element_size = field->element == DCJS_FIELD_SNOWFLAKE ? sizeof(discord_snowflake_t) : sizeof(void*);
+
+    if(len >= dcjs_max_len(field->len_size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if((len & (len - 1)) == 0) {
+        size_t cap = len > 0 ? len * 2 : 1;
+        uint8_t* _arr = decoder->arena
+            ? earena_realloc(decoder->arena, *arr, len * element_size, cap * element_size)
+            : realloc(*arr, cap * element_size);
+
+        if(!_arr) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        *arr = _arr;
+    }
+
+    memcpy(*arr + len * element_size, element, element_size);
+    dcjs_write_int(len_ptr, field->len_size, len + 1);
+
+    return ESP_OK;
+}
+
+static esp_err_t dcjs_decoder_handle_element(dcjs_decoder_t* decoder, dcjs_decoder_frame_t* frame, const dcjs_field_t* field, void* owner, const dcjs_event_t* event) {
+    switch(field->element) {
+        case DCJS_FIELD_SNOWFLAKE:
+            if(event->type == DCJS_EVENT_STRING) {
+                discord_snowflake_t id = discord_snowflake_from_strn(event->value, event->value_len);
+                return dcjs_array_append(decoder, field, owner, &id);
+            }
+            return ESP_OK;
+
+        case DCJS_FIELD_STRING:
+        case DCJS_FIELD_OBJECT:
+            break;
+
+        default:
+            return ESP_OK;
+    }
+
+    bool object = field->element == DCJS_FIELD_OBJECT;
+
+    if(object ? event->type != DCJS_EVENT_OBJECT_START : event->type != DCJS_EVENT_STRING) {
+        return ESP_OK; // skip elements of unexpected type
+    }
+
+    void* item = object ? dcjs_schema_alloc(decoder, field->schema) : dcjs_decoder_strdup(decoder, event);
+
+    if(!item) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = dcjs_array_append(decoder, field, owner, &item);
+
+    if(err != ESP_OK) {
+        if(object && !decoder->arena) {
+            dcjs_schema_free(field->schema, item);
+        } else {
+            dcjs_decoder_free(decoder, item);
+        }
+
+        return err;
+    }
+
+    if(object) {
+        frame->schema = field->schema;
+        frame->obj = item;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t dcjs_decoder_handle_member(dcjs_decoder_t* decoder, dcjs_decoder_frame_t* frame, const dcjs_field_t* field, void* owner, const dcjs_event_t* event) {
+    void* ptr = _dcjs_field_ptr(owner, field->offset);
+
+    switch(field->type) {
+        case DCJS_FIELD_STRING:
+            if(event->type == DCJS_EVENT_STRING) {
+                char* str = dcjs_decoder_strdup(decoder, event);
+
+                if(!str) {
+                    return ESP_ERR_NO_MEM;
+                }
+
+                dcjs_decoder_free(decoder, *((char**) ptr));
+                *((char**) ptr) = str;
+            }
+            break;
+
+        case DCJS_FIELD_INT:
+            if(event->type == DCJS_EVENT_NUMBER) {
+                dcjs_write_int(ptr, field->size, strtoll(event->value, NULL, 10));
+            }
+            break;
+
+        case DCJS_FIELD_BOOL:
+            if(event->type == DCJS_EVENT_TRUE || event->type == DCJS_EVENT_FALSE) {
+                *((bool*) ptr) = event->type == DCJS_EVENT_TRUE;
+            }
+            break;
+
+        case DCJS_FIELD_SNOWFLAKE:
+            if(event->type == DCJS_EVENT_STRING) {
+                *((discord_snowflake_t*) ptr) = discord_snowflake_from_strn(event->value, event->value_len);
+            }
+            break;
+
+        case DCJS_FIELD_OBJECT:
+            if(event->type == DCJS_EVENT_OBJECT_START) {
+                void* item = dcjs_schema_alloc(decoder, field->schema);
+
+                if(!item) {
+                    return ESP_ERR_NO_MEM;
+                }
+
+                dcjs_decoder_field_reset(decoder, field, owner); // in case of duplicated member
+                *((void**) ptr) = item;
+                frame->schema = field->schema;
+                frame->obj = item;
+            }
+            break;
+
+        case DCJS_FIELD_ARRAY:
+            if(event->type == DCJS_EVENT_ARRAY_START) {
+                dcjs_decoder_field_reset(decoder, field, owner);
+                frame->array = field;
+                frame->obj = owner;
+            }
+            break;
+    }
+
+    return ESP_OK;
+}
+
+void dcjs_decoder_begin(dcjs_decoder_t* decoder, const dcjs_schema_t* schema, uint8_t depth, earena_handle_t arena) {
+    decoder->schema = schema;
+    decoder->depth = depth;
+    decoder->arena = arena;
+    decoder->result = NULL;
+}
+
+esp_err_t dcjs_decoder_handle(dcjs_decoder_t* decoder, const dcjs_event_t* event) {
+    if(event->depth < decoder->depth || event->type == DCJS_EVENT_OBJECT_END || event->type == DCJS_EVENT_ARRAY_END) {
+        return ESP_OK;
+    }
+
+    uint8_t level = event->depth - decoder->depth;
+
+    if(level == 0) {
+        if(event->type != DCJS_EVENT_OBJECT_START) {
+            return ESP_OK; // null (or invalid) value, there is no result
+        }
+
+        if(!decoder->arena) {
+            dcjs_schema_free(decoder->schema, decoder->result);
+        }
+
+        if(!(decoder->result = dcjs_schema_alloc(decoder, decoder->schema))) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        decoder->frames[0] = (dcjs_decoder_frame_t) { .schema = decoder->schema, .obj = decoder->result };
+
+        return ESP_OK;
+    }
+
+    dcjs_decoder_frame_t* parent = &decoder->frames[level - 1];
+    dcjs_decoder_frame_t* frame = &decoder->frames[level];
+
+    *frame = (dcjs_decoder_frame_t) { 0 }; // skip the value by default
+
+    if(parent->array) {
+        return dcjs_decoder_handle_element(decoder, frame, parent->array, parent->obj, event);
+    }
+
+    const dcjs_field_t* field = parent->schema ? dcjs_schema_get_field(parent->schema, event->key) : NULL;
+
+    if(!field) {
+        return ESP_OK; // unknown member (or member of skipped value)
+    }
+
+    return dcjs_decoder_handle_member(decoder, frame, field, parent->obj, event);
+}
+
+void* dcjs_decoder_end(dcjs_decoder_t* decoder) {
+    void* result = decoder->result;
+    decoder->result = NULL;
+
+    return result;
+}
+
+void dcjs_decoder_abort(dcjs_decoder_t* decoder) {
+    if(!decoder->arena) {
+        dcjs_schema_free(decoder->schema, decoder->result);
+    }
+
+    decoder->result = NULL;
+}
+
+void dcjs_schema_free(const dcjs_schema_t* schema, void* obj) {
+    if(!schema || !obj)
+        return;
+
+    for(uint8_t i = 0; i < schema->fields_len; i++) {
+        dcjs_field_free(&schema->fields[i], obj);
+    }
+
+    free(obj);
+}
\ No newline at end of file
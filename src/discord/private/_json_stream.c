@@ -0,0 +1,536 @@
+#include "discord/private/_json_stream.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DCJS_INITIAL_TOKEN_CAPACITY 32
+
+typedef enum {
+    DCJS_STATE_VALUE,              /*<! Expecting value */
+    DCJS_STATE_VALUE_OR_END,       /*<! Expecting value or end of array */
+    DCJS_STATE_KEY,                /*<! Expecting member name */
+    DCJS_STATE_KEY_OR_END,         /*<! Expecting member name or end of object */
+    DCJS_STATE_COLON,              /*<! Expecting name separator */
+    DCJS_STATE_COMMA_OR_END,       /*<! Expecting value separator or end of container */
+    DCJS_STATE_STRING,
+    DCJS_STATE_STRING_ESCAPE,
+    DCJS_STATE_STRING_UNICODE,
+    DCJS_STATE_NUMBER,
+    DCJS_STATE_LITERAL,
+    DCJS_STATE_DONE                /*<! Root value is parsed */
+} dcjs_state_t;
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} dcjs_buffer_t;
+
+struct dcjs_parser {
+    dcjs_handler_t handler;
+    void* arg;
+    size_t max_token_len;
+    dcjs_state_t state;
+    esp_err_t err;
+    uint8_t depth;
+    uint32_t objects;              /*<! Bit per depth. Bit is set if container on that depth is an object */
+    dcjs_buffer_t token;
+    dcjs_buffer_t key;
+    bool has_key;
+    bool string_is_key;
+    uint32_t codepoint;
+    uint8_t codepoint_digits;
+    uint32_t high_surrogate;
+    const char* literal;
+    uint8_t literal_pos;
+    dcjs_event_type_t literal_type;
+};
+
+static esp_err_t dcjs_buffer_reserve(dcjs_parser_handle_t parser, dcjs_buffer_t* buffer, size_t n) {
+    size_t required = buffer->len + n + 1; // keep the space for null terminator
+
+    if(required <= buffer->cap) {
+        return ESP_OK;
+    }
+
+    if(required > parser->max_token_len + 1) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    size_t cap = buffer->cap > 0 ? buffer->cap : DCJS_INITIAL_TOKEN_CAPACITY;
+
+    while(cap < required) {
+        cap *= 2;
+    }
+
+    if(cap > parser->max_token_len + 1) {
+        cap = parser->max_token_len + 1;
+    }
+
+    char* data = realloc(buffer->data, cap);
+
+    if(!data) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    buffer->data = data;
+    buffer->cap = cap;
+
+    return ESP_OK;
+}
+
+static esp_err_t dcjs_buffer_append(dcjs_parser_handle_t parser, dcjs_buffer_t* buffer, const char* data, size_t n) {
+    esp_err_t err = dcjs_buffer_reserve(parser, buffer, n);
+
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    memcpy(buffer->data + buffer->len, data, n);
+    buffer->len += n;
+    buffer->data[buffer->len] = '\0';
+
+    return ESP_OK;
+}
+
+static esp_err_t dcjs_append_codepoint(dcjs_parser_handle_t parser, uint32_t cp) {
+    char utf8[4];
+    size_t n;
+
+    if(cp < 0x80) {
+        utf8[0] = (char) cp;
+        n = 1;
+    } else if(cp < 0x800) {
+        utf8[0] = (char) (0xC0 | (cp >> 6));
+        utf8[1] = (char) (0x80 | (cp & 0x3F));
+        n = 2;
+    } else if(cp < 0x10000) {
+        utf8[0] = (char) (0xE0 | (cp >> 12));
+        utf8[1] = (char) (0x80 | ((cp >> 6) & 0x3F));
+        utf8[2] = (char) (0x80 | (cp & 0x3F));
+        n = 3;
+    } else {
+        utf8[0] = (char) (0xF0 | (cp >> 18));
+        utf8[1] = (char) (0x80 | ((cp >> 12) & 0x3F));
+        utf8[2] = (char) (0x80 | ((cp >> 6) & 0x3F));
+        utf8[3] = (char) (0x80 | (cp & 0x3F));
+        n = 4;
+    }
+
+    return dcjs_buffer_append(parser, &parser->token, utf8, n);
+}
+
+static esp_err_t dcjs_emit(dcjs_parser_handle_t parser, dcjs_event_type_t type, const char* value, size_t value_len) {
+    dcjs_event_t event = {
+        .type = type,
+        .key = parser->has_key ? parser->key.data : NULL,
+        .value = value,
+        .value_len = value_len,
+        .depth = parser->depth
+    };
+
+    parser->has_key = false;
+
+    return parser->handler(&event, parser->arg);
+}
+
+static void dcjs_value_done(dcjs_parser_handle_t parser) {
+    parser->state = parser->depth == 0 ? DCJS_STATE_DONE : DCJS_STATE_COMMA_OR_END;
+}
+
+static bool dcjs_in_object(dcjs_parser_handle_t parser) {
+    return parser->depth > 0 && (parser->objects & (1UL << (parser->depth - 1)));
+}
+
+static esp_err_t dcjs_container_start(dcjs_parser_handle_t parser, bool object) {
+    if(parser->depth >= DCJS_MAX_DEPTH) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t err = dcjs_emit(parser, object ? DCJS_EVENT_OBJECT_START : DCJS_EVENT_ARRAY_START, NULL, 0);
+
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    if(object) {
+        parser->objects |= (1UL << parser->depth);
+    } else {
+        parser->objects &= ~(1UL << parser->depth);
+    }
+
+    parser->depth++;
+    parser->state = object ? DCJS_STATE_KEY_OR_END : DCJS_STATE_VALUE_OR_END;
+
+    return ESP_OK;
+}
+
+static esp_err_t dcjs_container_end(dcjs_parser_handle_t parser) {
+    bool object = dcjs_in_object(parser);
+    parser->depth--;
+    parser->has_key = false;
+
+    esp_err_t err = dcjs_emit(parser, object ? DCJS_EVENT_OBJECT_END : DCJS_EVENT_ARRAY_END, NULL, 0);
+    dcjs_value_done(parser);
+
+    return err;
+}
+
+static esp_err_t dcjs_string_start(dcjs_parser_handle_t parser, bool is_key) {
+    parser->state = DCJS_STATE_STRING;
+    parser->string_is_key = is_key;
+    parser->high_surrogate = 0;
+    parser->token.len = 0;
+    parser->token.data[0] = '\0';
+
+    return ESP_OK;
+}
+
+static esp_err_t dcjs_string_end(dcjs_parser_handle_t parser) {
+    if(parser->string_is_key) {
+        // swap buffers instead of copying, key needs to be kept until the value is parsed
+        dcjs_buffer_t key = parser->key;
+        parser->key = parser->token;
+        parser->token = key;
+        parser->has_key = true;
+        parser->state = DCJS_STATE_COLON;
+        return ESP_OK;
+    }
+
+    esp_err_t err = dcjs_emit(parser, DCJS_EVENT_STRING, parser->token.data, parser->token.len);
+    dcjs_value_done(parser);
+
+    return err;
+}
+
+static esp_err_t dcjs_number_end(dcjs_parser_handle_t parser) {
+    esp_err_t err = dcjs_emit(parser, DCJS_EVENT_NUMBER, parser->token.data, parser->token.len);
+    dcjs_value_done(parser);
+
+    return err;
+}
+
+static bool dcjs_is_ws(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static bool dcjs_is_number_chr(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+static esp_err_t dcjs_value_start(dcjs_parser_handle_t parser, char c) {
+    switch(c) {
+        case '{':
+            return dcjs_container_start(parser, true);
+
+        case '[':
+            return dcjs_container_start(parser, false);
+
+        case '"':
+            return dcjs_string_start(parser, false);
+
+        case 't':
+            parser->literal = "true";
+            parser->literal_type = DCJS_EVENT_TRUE;
+            break;
+
+        case 'f':
+            parser->literal = "false";
+            parser->literal_type = DCJS_EVENT_FALSE;
+            break;
+
+        case 'n':
+            parser->literal = "null";
+            parser->literal_type = DCJS_EVENT_NULL;
+            break;
+
+        default:
+            if(c == '-' || (c >= '0' && c <= '9')) {
+                parser->state = DCJS_STATE_NUMBER;
+                parser->token.len = 0;
+                return dcjs_buffer_append(parser, &parser->token, &c, 1);
+            }
+
+            return ESP_FAIL; // unexpected character
+    }
+
+    parser->state = DCJS_STATE_LITERAL;
+    parser->literal_pos = 1;
+
+    return ESP_OK;
+}
+
+static int dcjs_hex_value(char c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief Write pending high surrogate which is not followed by the low one
+ */
+static esp_err_t dcjs_flush_surrogate(dcjs_parser_handle_t parser) {
+    if(!parser->high_surrogate) {
+        return ESP_OK;
+    }
+
+    uint32_t cp = parser->high_surrogate;
+    parser->high_surrogate = 0;
+
+    return dcjs_append_codepoint(parser, cp);
+}
+
+static esp_err_t dcjs_string_escape(dcjs_parser_handle_t parser, char c) {
+    char unescaped;
+
+    if(c != 'u') {
+        esp_err_t err = dcjs_flush_surrogate(parser);
+
+        if(err != ESP_OK) {
+            return err;
+        }
+    }
+
+    switch(c) {
+        case '"':  unescaped = '"';  break;
+        case '\\': unescaped = '\\'; break;
+        case '/':  unescaped = '/';  break;
+        case 'b':  unescaped = '\b'; break;
+        case 'f':  unescaped = '\f'; break;
+        case 'n':  unescaped = '\n'; break;
+        case 'r':  unescaped = '\r'; break;
+        case 't':  unescaped = '\t'; break;
+        case 'u':
+            parser->state = DCJS_STATE_STRING_UNICODE;
+            parser->codepoint = 0;
+            parser->codepoint_digits = 0;
+            return ESP_OK;
+
+        default:
+            return ESP_FAIL; // invalid escape sequence
+    }
+
+    parser->state = DCJS_STATE_STRING;
+
+    return dcjs_buffer_append(parser, &parser->token, &unescaped, 1);
+}
+
+static esp_err_t dcjs_string_unicode(dcjs_parser_handle_t parser, char c) {
+    int hex = dcjs_hex_value(c);
+
+    if(hex < 0) {
+        return ESP_FAIL;
+    }
+
+    parser->codepoint = (parser->codepoint << 4) | hex;
+
+    if(++parser->codepoint_digits < 4) {
+        return ESP_OK;
+    }
+
+    parser->state = DCJS_STATE_STRING;
+    uint32_t cp = parser->codepoint;
+
+    if(cp >= 0xDC00 && cp <= 0xDFFF && parser->high_surrogate) {
+        cp = 0x10000 + ((parser->high_surrogate - 0xD800) << 10) + (cp - 0xDC00);
+        parser->high_surrogate = 0;
+    }
+
+    esp_err_t err = dcjs_flush_surrogate(parser);
+
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    if(cp >= 0xD800 && cp <= 0xDBFF) { // high surrogate, low one should follow
+        parser->high_surrogate = cp;
+        return ESP_OK;
+    }
+
+    return dcjs_append_codepoint(parser, cp);
+}
+
+dcjs_parser_handle_t dcjs_create(size_t max_token_len, dcjs_handler_t handler, void* arg) {
+    if(!handler || max_token_len == 0) {
+        return NULL;
+    }
+
+    dcjs_parser_handle_t parser = calloc(1, sizeof(struct dcjs_parser));
+
+    if(!parser) {
+        return NULL;
+    }
+
+    parser->handler = handler;
+    parser->arg = arg;
+    parser->max_token_len = max_token_len;
+
+    if(dcjs_buffer_reserve(parser, &parser->token, 0) != ESP_OK || dcjs_buffer_reserve(parser, &parser->key, 0) != ESP_OK) {
+        dcjs_destroy(parser);
+        return NULL;
+    }
+
+    dcjs_reset(parser);
+
+    return parser;
+}
+
+esp_err_t dcjs_feed(dcjs_parser_handle_t parser, const char* data, size_t len) {
+    if(!parser || (!data && len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = parser->err;
+    size_t i = 0;
+
+    while(err == ESP_OK && i < len) {
+        char c = data[i];
+
+        switch(parser->state) {
+            case DCJS_STATE_STRING: {
+                    // fast path: copy the whole run of regular characters at once
+                    size_t start = i;
+
+                    while(i < len && data[i] != '"' && data[i] != '\\') {
+                        i++;
+                    }
+
+                    if((i > start || (i < len && data[i] == '"')) && (err = dcjs_flush_surrogate(parser)) != ESP_OK) {
+                        break;
+                    }
+
+                    if(i > start && (err = dcjs_buffer_append(parser, &parser->token, data + start, i - start)) != ESP_OK) {
+                        break;
+                    }
+
+                    if(i == len) {
+                        break;
+                    }
+
+                    if(data[i++] == '"') {
+                        err = dcjs_string_end(parser);
+                    } else {
+                        parser->state = DCJS_STATE_STRING_ESCAPE;
+                    }
+                }
+                continue;
+
+            case DCJS_STATE_STRING_ESCAPE:
+                err = dcjs_string_escape(parser, c);
+                break;
+
+            case DCJS_STATE_STRING_UNICODE:
+                err = dcjs_string_unicode(parser, c);
+                break;
+
+            case DCJS_STATE_NUMBER:
+                if(dcjs_is_number_chr(c)) {
+                    err = dcjs_buffer_append(parser, &parser->token, &c, 1);
+                } else {
+                    err = dcjs_number_end(parser);
+                    continue; // character needs to be processed in the new state
+                }
+                break;
+
+            case DCJS_STATE_LITERAL:
+                if(c != parser->literal[parser->literal_pos++]) {
+                    err = ESP_FAIL;
+                } else if(parser->literal[parser->literal_pos] == '\0') {
+                    err = dcjs_emit(parser, parser->literal_type, NULL, 0);
+                    dcjs_value_done(parser);
+                }
+                break;
+
+            default:
+                if(dcjs_is_ws(c)) {
+                    break;
+                }
+
+                switch(parser->state) {
+                    case DCJS_STATE_VALUE:
+                        err = dcjs_value_start(parser, c);
+                        break;
+
+                    case DCJS_STATE_VALUE_OR_END:
+                        err = c == ']' ? dcjs_container_end(parser) : dcjs_value_start(parser, c);
+                        break;
+
+                    case DCJS_STATE_KEY_OR_END:
+                        err = c == '}' ? dcjs_container_end(parser) : (c == '"' ? dcjs_string_start(parser, true) : ESP_FAIL);
+                        break;
+
+                    case DCJS_STATE_KEY:
+                        err = c == '"' ? dcjs_string_start(parser, true) : ESP_FAIL;
+                        break;
+
+                    case DCJS_STATE_COLON:
+                        if(c == ':') {
+                            parser->state = DCJS_STATE_VALUE;
+                        } else {
+                            err = ESP_FAIL;
+                        }
+                        break;
+
+                    case DCJS_STATE_COMMA_OR_END:
+                        if(c == ',') {
+                            parser->state = dcjs_in_object(parser) ? DCJS_STATE_KEY : DCJS_STATE_VALUE;
+                        } else if(c == (dcjs_in_object(parser) ? '}' : ']')) {
+                            err = dcjs_container_end(parser);
+                        } else {
+                            err = ESP_FAIL;
+                        }
+                        break;
+
+                    default: // DCJS_STATE_DONE
+                        err = ESP_FAIL; // only whitespace is allowed after the root value
+                        break;
+                }
+                break;
+        }
+
+        i++;
+    }
+
+    parser->err = err;
+
+    return err;
+}
+
+esp_err_t dcjs_finish(dcjs_parser_handle_t parser) {
+    if(!parser) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(parser->err == ESP_OK && parser->state == DCJS_STATE_NUMBER && parser->depth == 0) { // root number cannot be terminated until the end
+        parser->err = dcjs_number_end(parser);
+    }
+
+    if(parser->err == ESP_OK && parser->state != DCJS_STATE_DONE) {
+        parser->err = ESP_FAIL; // incomplete document
+    }
+
+    return parser->err;
+}
+
+void dcjs_reset(dcjs_parser_handle_t parser) {
+    if(!parser)
+        return;
+
+    parser->state = DCJS_STATE_VALUE;
+    parser->err = ESP_OK;
+    parser->depth = 0;
+    parser->objects = 0;
+    parser->token.len = 0;
+    parser->key.len = 0;
+    parser->has_key = false;
+    parser->high_surrogate = 0;
+}
+
+void dcjs_destroy(dcjs_parser_handle_t parser) {
+    if(!parser)
+        return;
+
+    free(parser->token.data);
+    free(parser->key.data);
+    free(parser);
+}
\ No newline at end of file
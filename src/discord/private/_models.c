@@ -24,17 +24,34 @@ void discord_payload_free(discord_payload_t* payload) {
             break;
 
         case DISCORD_OP_DISPATCH:
-            discord_dispatch_event_data_free(payload);
+            if(payload->_arena) {
+                earena_destroy(payload->_arena);
+            } else {
+                discord_dispatch_event_data_free(payload);
+            }
             break;
 
         case DISCORD_OP_HEARTBEAT:
         case DISCORD_OP_HEARTBEAT_ACK:
+        case DISCORD_OP_RECONNECT:
             // Ignore
             break;
 
         case DISCORD_OP_IDENTIFY:
             discord_identify_free((discord_identify_t*) payload->d);
             break;
+
+        case DISCORD_OP_RESUME:
+            discord_resume_free((discord_resume_t*) payload->d);
+            break;
+
+        case DISCORD_OP_PRESENCE_UPDATE:
+            free(payload->d); // serialized presence
+            break;
+
+        case DISCORD_OP_INVALID_SESSION:
+            discord_invalid_session_free((discord_invalid_session_t*) payload->d);
+            break;
         
         default:
             DISCORD_LOGW("Cannot recognize payload type. Possible memory leak.");
@@ -64,6 +81,10 @@ void discord_dispatch_event_data_free(discord_payload_t* payload) {
         case DISCORD_EVENT_VOICE_STATE_UPDATED:
             return discord_voice_state_free((discord_voice_state_t*) payload->d);
 
+        case DISCORD_EVENT_RESUMED:
+            // RESUMED event does not carry any data
+            return;
+
         default:
             DISCORD_LOGW("Cannot recognize event type");
             return;
@@ -94,4 +115,28 @@ void discord_identify_free(discord_identify_t* identify) {
     free(identify->token);
     discord_identify_properties_free(identify->properties);
     free(identify);
+}
+
+void discord_resume_free(discord_resume_t* resume) {
+    if(!resume)
+        return;
+
+    free(resume->token);
+    free(resume->session_id);
+    free(resume);
+}
+
+void discord_invalid_session_free(discord_invalid_session_t* invalid_session) {
+    if(!invalid_session)
+        return;
+
+    free(invalid_session);
+}
+
+void discord_gateway_bot_free(discord_gateway_bot_t* gateway_bot) {
+    if(!gateway_bot)
+        return;
+
+    free(gateway_bot->url);
+    free(gateway_bot);
 }
\ No newline at end of file
@@ -6,37 +6,67 @@
 
 DISCORD_LOG_DEFINE_BASE();
 
-esp_err_t discord_role_get_all(discord_handle_t client, const char* guild_id, discord_role_t*** out_roles, discord_role_len_t* out_length) {
+esp_err_t discord_role_get_all(discord_handle_t client, discord_snowflake_t guild_id, discord_role_t*** out_roles, discord_role_len_t* out_length) {
     if(! client || ! guild_id || ! out_roles || ! out_length) {
         DISCORD_LOGE("Invalid args");
         return ESP_ERR_INVALID_ARG;
     }
 
-    esp_err_t err = ESP_OK;
-    discord_api_response_t* res = NULL;
-    
-    if((err = dcapi_get(client, estr_cat("/guilds/", guild_id, "/roles"), NULL, &res)) != ESP_OK) {
+    int len = 0;
+    esp_err_t err = dcapi_get_list(
+        client,
+        estr_cat("/guilds/", DISCORD_SNOWFLAKE_STR(guild_id), "/roles"),
+        &discord_role_schema,
+        (void***) out_roles,
+        &len
+    );
+
+    if(err != ESP_OK) {
         DISCORD_LOGE("Fail to fetch roles");
         return err;
     }
-    
-    if(dcapi_response_is_success(res) && res->data_len > 0) {
-        *out_roles = discord_json_list_deserialize_(role, res->data, res->data_len, out_length);
+
+    if(len > UINT8_MAX) { // discord_role_len_t
+        DISCORD_LOGW("Too many roles (%d), list is truncated", len);
+        while(len > UINT8_MAX) {
+            discord_role_free((*out_roles)[--len]);
+        }
+    }
+
+    *out_length = len;
+
+    return err;
+}
+
+esp_err_t discord_role_foreach(discord_handle_t client, discord_snowflake_t guild_id, discord_role_visitor_t visitor, void* arg) {
+    if(! client || ! guild_id || ! visitor) {
+        DISCORD_LOGE("Invalid args");
+        return ESP_ERR_INVALID_ARG;
     }
 
-    dcapi_response_free(client, res);
+    esp_err_t err = dcapi_foreach(
+        client,
+        estr_cat("/guilds/", DISCORD_SNOWFLAKE_STR(guild_id), "/roles"),
+        &discord_role_schema,
+        (discord_list_visitor_t) visitor,
+        arg
+    );
+
+    if(err != ESP_OK) {
+        DISCORD_LOGE("Fail to fetch roles");
+    }
 
     return err;
 }
 
-esp_err_t discord_role_is_in_ids_list(discord_role_t* role, char** role_ids, discord_role_len_t role_ids_len, bool* out_result) {
+esp_err_t discord_role_is_in_ids_list(discord_role_t* role, discord_snowflake_t* role_ids, discord_role_len_t role_ids_len, bool* out_result) {
     if(! role || ! role_ids || ! out_result) {
         return ESP_ERR_INVALID_ARG;
     }
     
     bool found = false;
     for(discord_role_len_t i = 0; i < role_ids_len; i++) {
-        if(estr_eq(role_ids[i], role->id)) {
+        if(role_ids[i] == role->id) {
             found = true;
             break;
         }
@@ -64,7 +94,6 @@ void discord_role_free(discord_role_t* role) {
     if(!role)
         return;
 
-    free(role->id);
     free(role->name);
     free(role->permissions);
     free(role);
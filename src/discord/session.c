@@ -16,5 +16,6 @@ void discord_session_free(discord_session_t* session) {
 
     discord_user_free(session->user);
     free(session->session_id);
+    free(session->resume_gateway_url);
     free(session);
 }
\ No newline at end of file
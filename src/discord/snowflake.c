@@ -0,0 +1,44 @@
+#include "discord/snowflake.h"
+#include <string.h>
+
+discord_snowflake_t discord_snowflake_from_strn(const char* str, size_t n) {
+    if(!str || n == 0 || n >= DISCORD_SNOWFLAKE_STR_SIZE) {
+        return DISCORD_SNOWFLAKE_NULL;
+    }
+
+    discord_snowflake_t snowflake = 0;
+
+    for(size_t i = 0; i < n; i++) {
+        uint8_t digit = (uint8_t) (str[i] - '0');
+
+        if(digit > 9 || snowflake > (UINT64_MAX - digit) / 10) { // not a digit or overflow
+            return DISCORD_SNOWFLAKE_NULL;
+        }
+
+        snowflake = snowflake * 10 + digit;
+    }
+
+    return snowflake;
+}
+
+discord_snowflake_t discord_snowflake_from_str(const char* str) {
+    return str ? discord_snowflake_from_strn(str, strnlen(str, DISCORD_SNOWFLAKE_STR_SIZE)) : DISCORD_SNOWFLAKE_NULL;
+}
+
+char* discord_snowflake_to_str(discord_snowflake_t snowflake, char* buffer) {
+    char digits[DISCORD_SNOWFLAKE_STR_SIZE];
+    size_t len = 0;
+
+    do {
+        digits[len++] = (char) ('0' + snowflake % 10);
+        snowflake /= 10;
+    } while(snowflake > 0);
+
+    for(size_t i = 0; i < len; i++) {
+        buffer[i] = digits[len - i - 1];
+    }
+
+    buffer[len] = '\0';
+
+    return buffer;
+}
\ No newline at end of file
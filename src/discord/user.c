@@ -33,7 +33,6 @@ void discord_user_free(discord_user_t* user) {
     if(!user)
         return;
 
-    free(user->id);
     free(user->username);
     free(user->discriminator);
     free(user);
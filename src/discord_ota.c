@@ -133,7 +133,7 @@ esp_err_t discord_ota_init(discord_handle_t client, discord_ota_config_t* config
         ota->config->administrator_only_disabled = config->administrator_only_disabled;
         if(config->channel) {
             ota->config->channel = cu_ctor(discord_channel_t,
-                .id = STRDUP(config->channel->id),
+                .id = config->channel->id,
                 .name = STRDUP(config->channel->name)
             );
         }
@@ -336,6 +336,22 @@ static esp_err_t ota_status_message_content(discord_ota_handle_t ota_hndl, char*
     return err;
 }
 
+typedef struct {
+    const char* name;
+    discord_snowflake_t id;        /*<! Id of found channel */
+} discord_ota_channel_lookup_t;
+
+static bool discord_ota_channel_visitor(discord_channel_t* channel, void* arg) {
+    discord_ota_channel_lookup_t* lookup = (discord_ota_channel_lookup_t*) arg;
+
+    if(estr_eq(channel->name, lookup->name)) {
+        lookup->id = channel->id;
+        return false; // stop, channel is found
+    }
+
+    return true;
+}
+
 /**
  * @brief Performs Discord OTA update
  * @param client Discord bot handle
@@ -396,7 +412,7 @@ static esp_err_t discord_ota_perform(discord_handle_t client, discord_message_t*
         const discord_session_t* session = NULL;
         discord_session_get_current(client, &session);
 
-        if(!estrn_eq(session->user->id, tagged_usr_wrd->id, tagged_usr_wrd->id_len)) { // not for us
+        if(discord_snowflake_from_strn(tagged_usr_wrd->id, tagged_usr_wrd->id_len) != session->user->id) { // not for us
             goto _return; // ignore message
         }
     }
@@ -406,7 +422,7 @@ static esp_err_t discord_ota_perform(discord_handle_t client, discord_message_t*
 
     if(ota->config->channel) {
         if(ota->config->channel->id) { // Channel Id has higher priority over Name
-            if(!estr_eq(ota->config->channel->id, firmware_message->channel_id)) {
+            if(ota->config->channel->id != firmware_message->channel_id) {
                 ota->error = DISCORD_OTA_ERR_OTA_WRONG_CHANNEL;
                 goto _error;
             } else {
@@ -420,26 +436,19 @@ static esp_err_t discord_ota_perform(discord_handle_t client, discord_message_t*
             goto _error_quiet;
         }
 
-        discord_channel_t** channels = NULL;
-        int channels_len = 0;
-        if((err = discord_guild_get_channels(
+        discord_ota_channel_lookup_t lookup = { .name = ota->config->channel->name };
+
+        if((err = discord_guild_foreach_channel(
             client,
             &(discord_guild_t) { .id = firmware_message->guild_id },
-            &channels,
-            &channels_len
+            discord_ota_channel_visitor,
+            &lookup
         )) != ESP_OK) {
             ota->error = DISCORD_OTA_ERR_FAIL_TO_FETCH_CHANNELS;
             goto _error_quiet;
         }
 
-        discord_channel_t* channel = discord_channel_get_from_array_by_name(
-            channels, channels_len, ota->config->channel->name
-        );
-
-        bool channel_found = channel != NULL;
-        bool correct_channel = channel_found && estr_eq(channel->id, firmware_message->channel_id);
-
-        cu_list_freex(channels, channels_len, discord_channel_free);
+        bool correct_channel = lookup.id && lookup.id == firmware_message->channel_id;
 
         if(!correct_channel) {
             ota->error = DISCORD_OTA_ERR_OTA_WRONG_CHANNEL;
@@ -0,0 +1,134 @@
+#include "earena.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EARENA_ALIGNMENT _Alignof(max_align_t)  /*<! Same as malloc, so any type (ex: double or int64_t) can be allocated */
+#define EARENA_ALIGN(size) (((size) + (EARENA_ALIGNMENT - 1)) & ~(EARENA_ALIGNMENT - 1))
+
+typedef struct earena_block {
+    struct earena_block* next;
+    size_t size;
+    size_t used;
+    _Alignas(max_align_t) uint8_t data[];
+} earena_block_t;
+
+struct earena {
+    earena_block_t* head;          /*<! Current block, the one from which is allocated */
+    size_t block_size;
+    void* last;                    /*<! Last allocation (can be extended in place) */
+};
+
+static earena_block_t* earena_block_create(size_t size) {
+    earena_block_t* block = malloc(sizeof(earena_block_t) + size);
+
+    if(block) {
+        block->next = NULL;
+        block->size = size;
+        block->used = 0;
+    }
+
+    return block;
+}
+
+earena_handle_t earena_create(size_t block_size) {
+    earena_handle_t arena = calloc(1, sizeof(struct earena));
+
+    if(!arena) {
+        return NULL;
+    }
+
+    arena->block_size = EARENA_ALIGN(block_size > 0 ? block_size : EARENA_ALIGNMENT);
+
+    return arena;
+}
+
+void* earena_calloc(earena_handle_t arena, size_t size) {
+    if(!arena)
+        return NULL;
+
+    size = EARENA_ALIGN(size);
+    earena_block_t* block = arena->head;
+
+    if(!block || block->size - block->used < size) {
+        size_t block_size = block ? arena->block_size * 2 : arena->block_size;
+
+        if(block_size < size) {
+            block_size = size;
+        }
+
+        if(!(block = earena_block_create(block_size))) {
+            return NULL;
+        }
+
+        arena->block_size = block_size;
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    void* ptr = block->data + block->used;
+    block->used += size;
+    arena->last = ptr;
+
+    return memset(ptr, 0, size);
+}
+
+void* earena_realloc(earena_handle_t arena, void* ptr, size_t size, size_t new_size) {
+    if(!arena)
+        return NULL;
+
+    if(!ptr) {
+        return earena_calloc(arena, new_size);
+    }
+
+    earena_block_t* block = arena->head;
+    size = EARENA_ALIGN(size);
+    new_size = EARENA_ALIGN(new_size);
+
+    if(new_size <= size) {
+        return ptr;
+    }
+
+    if(ptr == arena->last && block->size - block->used >= new_size - size) { // extend in place
+        memset(block->data + block->used, 0, new_size - size);
+        block->used += new_size - size;
+        return ptr;
+    }
+
+    void* new_ptr = earena_calloc(arena, new_size);
+
+    if(new_ptr) {
+        memcpy(new_ptr, ptr, size);
+    }
+
+    return new_ptr;
+}
+
+char* earena_strndup(earena_handle_t arena, const char* str, size_t n) {
+    if(!str)
+        return NULL;
+
+    char* copy = earena_calloc(arena, n + 1);
+
+    if(copy) {
+        memcpy(copy, str, n);
+    }
+
+    return copy;
+}
+
+void earena_destroy(earena_handle_t arena) {
+    if(!arena)
+        return;
+
+    earena_block_t* block = arena->head;
+
+    while(block) {
+        earena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(arena);
+}
\ No newline at end of file
@@ -98,6 +98,14 @@ size_t estrn_chrcnt(const char* str, char chr, size_t n) {
 	return cnt;
 }
 
+uint32_t estrn_hash(uint32_t hash, const char* str, size_t n) {
+    for(size_t i = 0; str && i < n; i++) {
+        hash = (hash ^ (uint8_t) str[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
 char** estr_split(const char* str, const char chr, size_t* out_len) {
     if(!str || !out_len)
         return NULL;
@@ -0,0 +1,95 @@
+#include "unity.h"
+#include "discord.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_api.h"
+#include <stdlib.h>
+
+#define route(method, uri) dcapi_route_hash(HTTP_METHOD_##method, uri)
+
+TEST_CASE("route hash ignores minor parameters", "[api][ratelimit]")
+{
+    TEST_ASSERT_EQUAL_UINT32(route(GET, "/channels/111/messages/222"), route(GET, "/channels/111/messages/333"));
+    TEST_ASSERT_EQUAL_UINT32(route(GET, "/guilds/111/members/222"), route(GET, "/guilds/111/members/333"));
+    TEST_ASSERT_EQUAL_UINT32(route(GET, "/users/111"), route(GET, "/users/222"));
+
+    // query and duplicated slashes do not matter
+    TEST_ASSERT_EQUAL_UINT32(route(GET, "/channels/111/messages"), route(GET, "/channels/111/messages?limit=10"));
+    TEST_ASSERT_EQUAL_UINT32(route(GET, "/channels/111/messages"), route(GET, "channels//111/messages/"));
+}
+
+TEST_CASE("route hash is split by method and major parameters", "[api][ratelimit]")
+{
+    TEST_ASSERT_NOT_EQUAL(route(GET, "/channels/111/messages"), route(POST, "/channels/111/messages"));
+    TEST_ASSERT_NOT_EQUAL(route(POST, "/channels/111/messages"), route(POST, "/channels/222/messages"));
+    TEST_ASSERT_NOT_EQUAL(route(GET, "/guilds/111/members/333"), route(GET, "/guilds/222/members/333"));
+    TEST_ASSERT_NOT_EQUAL(route(POST, "/webhooks/111/token"), route(POST, "/webhooks/222/token"));
+    TEST_ASSERT_NOT_EQUAL(route(GET, "/channels/111/messages"), route(GET, "/channels/111/pins"));
+}
+
+TEST_CASE("route hash shares one bucket for reactions of the message", "[api][ratelimit]")
+{
+    TEST_ASSERT_EQUAL_UINT32(
+        route(PUT, "/channels/111/messages/222/reactions/%F0%9F%91%8D/@me"),
+        route(PUT, "/channels/111/messages/222/reactions/custom:333/@me")
+    );
+    TEST_ASSERT_EQUAL_UINT32(
+        route(DELETE, "/channels/111/messages/222/reactions/%F0%9F%91%8D/@me"),
+        route(DELETE, "/channels/111/messages/444/reactions/%F0%9F%91%8E/555")
+    );
+    TEST_ASSERT_NOT_EQUAL(
+        route(PUT, "/channels/111/messages/222/reactions/%F0%9F%91%8D/@me"),
+        route(PUT, "/channels/666/messages/222/reactions/%F0%9F%91%8D/@me")
+    );
+}
+
+TEST_CASE("rate limit bucket is found by route", "[api][ratelimit]")
+{
+    discord_handle_t client = calloc(1, sizeof(struct discord));
+    TEST_ASSERT_NOT_NULL(client);
+
+    TEST_ASSERT_NULL(dcapi_bucket_get(client, 100, false));
+
+    discord_api_bucket_t* bucket = dcapi_bucket_get(client, 100, true);
+    TEST_ASSERT_NOT_NULL(bucket);
+    TEST_ASSERT_EQUAL_UINT32(100, bucket->route);
+    TEST_ASSERT_EQUAL(-1, bucket->remaining);
+    TEST_ASSERT_GREATER_THAN(0, bucket->used_ms);
+
+    bucket->remaining = 3;
+    TEST_ASSERT_EQUAL_PTR(bucket, dcapi_bucket_get(client, 100, false));
+    TEST_ASSERT_EQUAL_PTR(bucket, dcapi_bucket_get(client, 100, true)); // existing bucket is not reset
+    TEST_ASSERT_EQUAL(3, bucket->remaining);
+
+    free(client);
+}
+
+TEST_CASE("least recently used rate limit bucket is replaced", "[api][ratelimit]")
+{
+    discord_handle_t client = calloc(1, sizeof(struct discord));
+    TEST_ASSERT_NOT_NULL(client);
+
+    for(uint32_t i = 0; i < DISCORD_API_BUCKETS; i++) {
+        discord_api_bucket_t* bucket = dcapi_bucket_get(client, 100 + i, true);
+        TEST_ASSERT_NOT_NULL(bucket);
+        bucket->used_ms = 1000 + i; // route 100 is the oldest one
+    }
+
+    for(uint32_t i = 0; i < DISCORD_API_BUCKETS; i++) {
+        TEST_ASSERT_NOT_NULL(dcapi_bucket_get(client, 100 + i, false));
+    }
+
+    dcapi_bucket_get(client, 100, false)->used_ms = 2000; // route 101 is the oldest one now
+
+    discord_api_bucket_t* bucket = dcapi_bucket_get(client, 200, true);
+    TEST_ASSERT_EQUAL_UINT32(200, bucket->route);
+    TEST_ASSERT_EQUAL(-1, bucket->remaining);
+
+    TEST_ASSERT_NULL(dcapi_bucket_get(client, 101, false));
+    TEST_ASSERT_NOT_NULL(dcapi_bucket_get(client, 100, false));
+
+    for(uint32_t i = 2; i < DISCORD_API_BUCKETS; i++) {
+        TEST_ASSERT_NOT_NULL(dcapi_bucket_get(client, 100 + i, false));
+    }
+
+    free(client);
+}
\ No newline at end of file
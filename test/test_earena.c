@@ -0,0 +1,110 @@
+#include "unity.h"
+#include "earena.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static bool is_zero(const uint8_t* ptr, size_t size) {
+    for(size_t i = 0; i < size; i++) {
+        if(ptr[i] != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+TEST_CASE("earena allocates aligned zeroed memory", "[earena]")
+{
+    earena_handle_t arena = earena_create(32);
+    TEST_ASSERT_NOT_NULL(arena);
+
+    for(size_t size = 1; size < 100; size += 7) {
+        uint8_t* ptr = earena_calloc(arena, size);
+
+        TEST_ASSERT_NOT_NULL(ptr);
+        TEST_ASSERT_EQUAL(0, (uintptr_t) ptr % _Alignof(max_align_t));
+        TEST_ASSERT_TRUE(is_zero(ptr, size));
+        memset(ptr, 0xAA, size);
+    }
+
+    earena_destroy(arena);
+}
+
+TEST_CASE("earena allocates block big enough for large allocation", "[earena]")
+{
+    earena_handle_t arena = earena_create(16);
+    TEST_ASSERT_NOT_NULL(arena);
+
+    uint8_t* small = earena_calloc(arena, 8);
+    uint8_t* large = earena_calloc(arena, 4096);
+
+    TEST_ASSERT_NOT_NULL(small);
+    TEST_ASSERT_NOT_NULL(large);
+    TEST_ASSERT_TRUE(is_zero(large, 4096));
+    memset(large, 0xAA, 4096);
+    memset(small, 0x55, 8);
+    TEST_ASSERT_EQUAL(0xAA, large[0]);
+
+    earena_destroy(arena);
+}
+
+TEST_CASE("earena extends the last allocation in place", "[earena]")
+{
+    earena_handle_t arena = earena_create(256);
+    TEST_ASSERT_NOT_NULL(arena);
+
+    uint8_t* ptr = earena_calloc(arena, 16);
+    memset(ptr, 0xAA, 16);
+
+    uint8_t* extended = earena_realloc(arena, ptr, 16, 64);
+    TEST_ASSERT_EQUAL_PTR(ptr, extended);
+    TEST_ASSERT_EQUAL(0xAA, extended[15]);
+    TEST_ASSERT_TRUE(is_zero(extended + 16, 48));
+
+    // shrinking keeps the memory
+    TEST_ASSERT_EQUAL_PTR(ptr, earena_realloc(arena, ptr, 64, 8));
+
+    earena_destroy(arena);
+}
+
+TEST_CASE("earena copies allocation which cannot be extended", "[earena]")
+{
+    earena_handle_t arena = earena_create(64);
+    TEST_ASSERT_NOT_NULL(arena);
+
+    uint8_t* ptr = earena_calloc(arena, 16);
+    memset(ptr, 0xAA, 16);
+    uint8_t* other = earena_calloc(arena, 8);
+    memset(other, 0x55, 8);
+
+    // not the last allocation
+    uint8_t* moved = earena_realloc(arena, ptr, 16, 32);
+    TEST_ASSERT_NOT_NULL(moved);
+    TEST_ASSERT_NOT_EQUAL((uintptr_t) ptr, (uintptr_t) moved);
+    TEST_ASSERT_EQUAL(0xAA, moved[0]);
+    TEST_ASSERT_EQUAL(0xAA, moved[15]);
+    TEST_ASSERT_TRUE(is_zero(moved + 16, 16));
+
+    // last allocation, but there is no space left in the block
+    uint8_t* grown = earena_realloc(arena, moved, 32, 1024);
+    TEST_ASSERT_NOT_NULL(grown);
+    TEST_ASSERT_EQUAL(0xAA, grown[15]);
+    TEST_ASSERT_TRUE(is_zero(grown + 16, 1024 - 16));
+    TEST_ASSERT_EQUAL(0x55, other[7]);
+
+    earena_destroy(arena);
+}
+
+TEST_CASE("earena duplicates strings", "[earena]")
+{
+    earena_handle_t arena = earena_create(8);
+    TEST_ASSERT_NOT_NULL(arena);
+
+    TEST_ASSERT_EQUAL_STRING("disc", earena_strndup(arena, "discord", 4));
+    TEST_ASSERT_EQUAL_STRING("", earena_strndup(arena, "discord", 0));
+    TEST_ASSERT_NULL(earena_strndup(arena, NULL, 4));
+
+    earena_destroy(arena);
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "unity.h"
+#include "discord.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_events.h"
+
+#define TEST_HANDLERS (DISCORD_EVENT_HANDLERS_INITIAL * 3)
+
+static int calls[TEST_HANDLERS];
+static int order[TEST_HANDLERS];
+static int called;
+
+static void handler(int index) {
+    calls[index]++;
+    order[called++] = index;
+}
+
+#define TEST_HANDLER(i) static void handler_##i(void* arg, esp_event_base_t base, int32_t event_id, void* event_data) { handler(i); }
+
+TEST_HANDLER(0) TEST_HANDLER(1) TEST_HANDLER(2) TEST_HANDLER(3) TEST_HANDLER(4) TEST_HANDLER(5)
+TEST_HANDLER(6) TEST_HANDLER(7) TEST_HANDLER(8) TEST_HANDLER(9) TEST_HANDLER(10) TEST_HANDLER(11)
+
+static const esp_event_handler_t handlers[TEST_HANDLERS] = {
+    handler_0, handler_1, handler_2, handler_3, handler_4, handler_5,
+    handler_6, handler_7, handler_8, handler_9, handler_10, handler_11
+};
+
+static void reset_calls(void) {
+    memset(calls, 0, sizeof(calls));
+    memset(order, 0, sizeof(order));
+    called = 0;
+}
+
+TEST_CASE("event handlers array grows beyond initial capacity", "[events]")
+{
+    discord_handle_t client = discord_create(&(discord_config_t) { .intents = DISCORD_INTENT_GUILD_MESSAGES });
+    TEST_ASSERT_NOT_NULL(client);
+
+    for(int i = 0; i < TEST_HANDLERS; i++) {
+        TEST_ESP_OK(discord_register_events(client, DISCORD_EVENT_CONNECTED, handlers[i], NULL));
+    }
+
+    TEST_ASSERT_EQUAL(TEST_HANDLERS, client->handlers[DISCORD_EVENT_CONNECTED].len);
+    TEST_ASSERT_GREATER_OR_EQUAL(TEST_HANDLERS, client->handlers[DISCORD_EVENT_CONNECTED].capacity);
+
+    // registering the same handler again does not add it
+    TEST_ESP_OK(discord_register_events(client, DISCORD_EVENT_CONNECTED, handlers[0], NULL));
+    TEST_ASSERT_EQUAL(TEST_HANDLERS, client->handlers[DISCORD_EVENT_CONNECTED].len);
+
+    reset_calls();
+    TEST_ESP_OK(dcev_dispatch(client, DISCORD_EVENT_CONNECTED, NULL));
+    TEST_ASSERT_EQUAL(TEST_HANDLERS, called);
+
+    for(int i = 0; i < TEST_HANDLERS; i++) {
+        TEST_ASSERT_EQUAL(1, calls[i]);
+        TEST_ASSERT_EQUAL(i, order[i]); // order of registration
+    }
+
+    TEST_ESP_OK(discord_unregister_events(client, DISCORD_EVENT_CONNECTED, handlers[1]));
+
+    reset_calls();
+    TEST_ESP_OK(dcev_dispatch(client, DISCORD_EVENT_CONNECTED, NULL));
+    TEST_ASSERT_EQUAL(TEST_HANDLERS - 1, called);
+    TEST_ASSERT_EQUAL(0, calls[1]);
+    TEST_ASSERT_EQUAL(2, order[1]);
+
+    TEST_ESP_OK(discord_destroy(client));
+}
+
+TEST_CASE("any handlers are invoked before event handlers", "[events]")
+{
+    discord_handle_t client = discord_create(&(discord_config_t) { .intents = DISCORD_INTENT_GUILD_MESSAGES });
+    TEST_ASSERT_NOT_NULL(client);
+
+    // more than fits into the snapshot on the stack
+    for(int i = 0; i < TEST_HANDLERS; i++) {
+        TEST_ESP_OK(discord_register_events(client, i % 2 ? DISCORD_EVENT_CONNECTED : DISCORD_EVENT_ANY, handlers[i], NULL));
+    }
+
+    reset_calls();
+    TEST_ESP_OK(dcev_dispatch(client, DISCORD_EVENT_CONNECTED, NULL));
+    TEST_ASSERT_EQUAL(TEST_HANDLERS, called);
+
+    for(int i = 0; i < TEST_HANDLERS / 2; i++) {
+        TEST_ASSERT_EQUAL(i * 2, order[i]);
+        TEST_ASSERT_EQUAL(i * 2 + 1, order[TEST_HANDLERS / 2 + i]);
+    }
+
+    TEST_ESP_OK(discord_destroy(client));
+}
+
+static void handler_unregistering(void* arg, esp_event_base_t base, int32_t event_id, void* event_data) {
+    discord_handle_t client = (discord_handle_t) arg;
+
+    called++;
+
+    // neither of them blocks, even though the handler itself is still being invoked
+    TEST_ESP_OK(discord_unregister_events(client, DISCORD_EVENT_CONNECTED, handler_unregistering));
+    TEST_ESP_OK(discord_unregister_events(client, DISCORD_EVENT_CONNECTED, handlers[1]));
+}
+
+TEST_CASE("handler unregistered during dispatch is not invoked anymore", "[events]")
+{
+    discord_handle_t client = discord_create(&(discord_config_t) { .intents = DISCORD_INTENT_GUILD_MESSAGES });
+    TEST_ASSERT_NOT_NULL(client);
+
+    TEST_ESP_OK(discord_register_events(client, DISCORD_EVENT_CONNECTED, handler_unregistering, client));
+    TEST_ESP_OK(discord_register_events(client, DISCORD_EVENT_CONNECTED, handlers[1], NULL));
+    TEST_ESP_OK(discord_register_events(client, DISCORD_EVENT_CONNECTED, handlers[2], NULL));
+
+    reset_calls();
+    TEST_ESP_OK(dcev_dispatch(client, DISCORD_EVENT_CONNECTED, NULL));
+    TEST_ASSERT_EQUAL(2, called);
+    TEST_ASSERT_EQUAL(0, calls[1]); // already in the snapshot, but unregistered before its turn
+    TEST_ASSERT_EQUAL(1, calls[2]);
+    TEST_ASSERT_EQUAL(1, client->handlers[DISCORD_EVENT_CONNECTED].len);
+
+    TEST_ESP_OK(discord_destroy(client));
+}
+
+static uint16_t received_shard_id;
+
+static void handler_shard(void* arg, esp_event_base_t base, int32_t event_id, void* event_data) {
+    received_shard_id = ((discord_event_data_t*) event_data)->shard_id;
+}
+
+TEST_CASE("event data carries the shard id of the client", "[events]")
+{
+    discord_handle_t client = discord_create(&(discord_config_t) { .intents = DISCORD_INTENT_GUILD_MESSAGES, .shard_id = 3, .shard_count = 4 });
+    TEST_ASSERT_NOT_NULL(client);
+
+    TEST_ESP_OK(discord_register_events(client, DISCORD_EVENT_CONNECTED, handler_shard, NULL));
+
+    received_shard_id = 0;
+    TEST_ESP_OK(dcev_dispatch(client, DISCORD_EVENT_CONNECTED, NULL));
+    TEST_ASSERT_EQUAL(3, received_shard_id);
+
+    TEST_ESP_OK(discord_destroy(client));
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "unity.h"
+#include "nvs_flash.h"
+#include "discord.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_gateway.h"
+
+static void nvs_init(void) {
+    esp_err_t err = nvs_flash_init();
+
+    if(err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        TEST_ESP_OK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+
+    TEST_ESP_OK(err);
+}
+
+static bool gateway_info_cached(void) {
+    nvs_handle_t nvs;
+    size_t size = 0;
+
+    TEST_ESP_OK(nvs_open(DISCORD_NVS_NAMESPACE, NVS_READONLY, &nvs));
+    esp_err_t err = nvs_get_blob(nvs, DISCORD_NVS_KEY_GATEWAY_BOT, NULL, &size);
+    nvs_close(nvs);
+
+    return err == ESP_OK && size > 0;
+}
+
+/**
+ * Requires network connection and valid bot token (CONFIG_DISCORD_TOKEN)
+ */
+TEST_CASE("gateway info is fetched and cached on cold start", "[gateway][network]")
+{
+    nvs_handle_t nvs;
+
+    nvs_init();
+    TEST_ESP_OK(nvs_open(DISCORD_NVS_NAMESPACE, NVS_READWRITE, &nvs));
+    nvs_erase_key(nvs, DISCORD_NVS_KEY_GATEWAY_BOT);
+    nvs_commit(nvs);
+    nvs_close(nvs);
+    TEST_ASSERT_FALSE(gateway_info_cached());
+
+    discord_handle_t client = discord_create(&(discord_config_t) { .intents = DISCORD_INTENT_GUILD_MESSAGES });
+    TEST_ASSERT_NOT_NULL(client);
+
+    // gateway is not connected yet, so GET /gateway/bot cannot go through the api client
+    TEST_ASSERT_LESS_THAN(DISCORD_STATE_CONNECTED, client->state);
+    TEST_ASSERT_FALSE(client->gw_info.loaded);
+
+    TEST_ESP_OK(dcgw_info_load(client));
+    TEST_ASSERT_TRUE(client->gw_info.loaded);
+    TEST_ASSERT_GREATER_THAN(0, client->gw_info.shards);
+    TEST_ASSERT_GREATER_THAN(0, client->gw_info.max_concurrency);
+    TEST_ASSERT_TRUE(gateway_info_cached());
+
+    int shards = client->gw_info.shards;
+    TEST_ESP_OK(discord_destroy(client));
+
+    // warm start is served from NVS
+    client = discord_create(&(discord_config_t) { .intents = DISCORD_INTENT_GUILD_MESSAGES });
+    TEST_ASSERT_NOT_NULL(client);
+    TEST_ESP_OK(dcgw_info_load(client));
+    TEST_ASSERT_TRUE(client->gw_info.loaded);
+    TEST_ASSERT_EQUAL(shards, client->gw_info.shards);
+    TEST_ESP_OK(discord_destroy(client));
+}
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "unity.h"
+#include "discord/private/_json_schema.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    char* name;
+    int value;
+} test_item_t;
+
+typedef struct {
+    discord_snowflake_t id;
+    char* name;
+    int16_t count;
+    bool flag;
+    test_item_t* item;
+    test_item_t** items;
+    uint8_t items_len;
+    char** tags;
+    uint16_t tags_len;
+    discord_snowflake_t* ids;
+    uint8_t ids_len;
+} test_model_t;
+
+static const dcjs_field_t test_item_fields[] = {
+    DCJS_FIELD_STR(test_item_t, name, "name"),
+    DCJS_FIELD_NUM(test_item_t, value, "value")
+};
+
+static const dcjs_schema_t test_item_schema = DCJS_SCHEMA(test_item_t, test_item_fields);
+
+static const dcjs_field_t test_model_fields[] = {
+    DCJS_FIELD_ID(test_model_t, id, "id"),
+    DCJS_FIELD_STR(test_model_t, name, "name"),
+    DCJS_FIELD_NUM(test_model_t, count, "count"),
+    DCJS_FIELD_BOOLEAN(test_model_t, flag, "flag"),
+    DCJS_FIELD_OBJ(test_model_t, item, "item", &test_item_schema),
+    DCJS_FIELD_ARR(test_model_t, items, items_len, "items", &test_item_schema),
+    DCJS_FIELD_ARR_STR(test_model_t, tags, tags_len, "tags"),
+    DCJS_FIELD_ARR_ID(test_model_t, ids, ids_len, "ids")
+};
+
+static const dcjs_schema_t test_model_schema = DCJS_SCHEMA(test_model_t, test_model_fields);
+
+static esp_err_t decoder_handler(const dcjs_event_t* event, void* arg) {
+    return dcjs_decoder_handle((dcjs_decoder_t*) arg, event);
+}
+
+/**
+ * @brief Decode the model from the document fed in small chunks
+ * @param arena Arena for the model or NULL to allocate it on heap
+ */
+static esp_err_t decode_(const char* json, earena_handle_t arena, test_model_t** out_model) {
+    static dcjs_decoder_t decoder;
+    dcjs_parser_handle_t parser = dcjs_create(128, decoder_handler, &decoder);
+    size_t len = strlen(json);
+    esp_err_t err = ESP_OK;
+
+    TEST_ASSERT_NOT_NULL(parser);
+    dcjs_decoder_begin(&decoder, &test_model_schema, 0, arena);
+
+    for(size_t i = 0; i < len && err == ESP_OK; i += 7) {
+        err = dcjs_feed(parser, json + i, len - i < 7 ? len - i : 7);
+    }
+
+    if(err == ESP_OK) {
+        err = dcjs_finish(parser);
+    }
+
+    if(err == ESP_OK) {
+        *out_model = dcjs_decoder_end(&decoder);
+    } else {
+        dcjs_decoder_abort(&decoder);
+    }
+
+    dcjs_destroy(parser);
+
+    return err;
+}
+
+static esp_err_t decode(const char* json, test_model_t** out_model) {
+    return decode_(json, NULL, out_model);
+}
+
+TEST_CASE("schema decoder maps members into struct", "[json_schema]")
+{
+    test_model_t* model = NULL;
+
+    TEST_ESP_OK(decode(
+        "{\"id\": \"175928847299117063\", \"name\": \"model\", \"count\": -12, \"flag\": true,"
+        " \"unknown\": {\"name\": \"skipped\", \"items\": [{\"name\": \"skipped\"}]},"
+        " \"item\": {\"name\": \"item\", \"value\": 7, \"extra\": [1, 2]},"
+        " \"items\": [{\"name\": \"a\", \"value\": 1}, null, {\"value\": 2}],"
+        " \"tags\": [\"x\", 1, \"y\"], \"ids\": [\"1\", \"18446744073709551615\"]}",
+        &model
+    ));
+
+    TEST_ASSERT_NOT_NULL(model);
+    TEST_ASSERT_EQUAL_UINT64(175928847299117063ULL, model->id);
+    TEST_ASSERT_EQUAL_STRING("model", model->name);
+    TEST_ASSERT_EQUAL(-12, model->count);
+    TEST_ASSERT_TRUE(model->flag);
+
+    TEST_ASSERT_NOT_NULL(model->item);
+    TEST_ASSERT_EQUAL_STRING("item", model->item->name);
+    TEST_ASSERT_EQUAL(7, model->item->value);
+
+    // elements of unexpected type are skipped
+    TEST_ASSERT_EQUAL(2, model->items_len);
+    TEST_ASSERT_EQUAL_STRING("a", model->items[0]->name);
+    TEST_ASSERT_NULL(model->items[1]->name);
+    TEST_ASSERT_EQUAL(2, model->items[1]->value);
+
+    TEST_ASSERT_EQUAL(2, model->tags_len);
+    TEST_ASSERT_EQUAL_STRING("x", model->tags[0]);
+    TEST_ASSERT_EQUAL_STRING("y", model->tags[1]);
+
+    TEST_ASSERT_EQUAL(2, model->ids_len);
+    TEST_ASSERT_EQUAL_UINT64(1, model->ids[0]);
+    TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, model->ids[1]);
+
+    dcjs_schema_free(&test_model_schema, model);
+}
+
+TEST_CASE("schema decoder keeps the last of duplicated members", "[json_schema]")
+{
+    test_model_t* model = NULL;
+
+    TEST_ESP_OK(decode(
+        "{\"name\": \"first\", \"item\": {\"name\": \"first\"}, \"items\": [{\"value\": 1}, {\"value\": 2}], \"tags\": [\"first\"], \"ids\": [\"1\"],"
+        " \"name\": \"second\", \"item\": {\"value\": 2}, \"items\": [{\"value\": 3}], \"tags\": [], \"ids\": [\"2\", \"3\"], \"name\": null}",
+        &model
+    ));
+
+    TEST_ASSERT_EQUAL_STRING("second", model->name); // null does not overwrite the value
+
+    TEST_ASSERT_NULL(model->item->name); // object is replaced, not merged
+    TEST_ASSERT_EQUAL(2, model->item->value);
+
+    TEST_ASSERT_EQUAL(1, model->items_len); // array is replaced, not appended
+    TEST_ASSERT_EQUAL(3, model->items[0]->value);
+
+    TEST_ASSERT_EQUAL(0, model->tags_len);
+    TEST_ASSERT_NULL(model->tags);
+
+    TEST_ASSERT_EQUAL(2, model->ids_len);
+    TEST_ASSERT_EQUAL_UINT64(2, model->ids[0]);
+    TEST_ASSERT_EQUAL_UINT64(3, model->ids[1]);
+
+    dcjs_schema_free(&test_model_schema, model);
+}
+
+TEST_CASE("schema decoder grows arrays", "[json_schema]")
+{
+    char json[2048] = "{\"tags\": [";
+    test_model_t* model = NULL;
+
+    for(int i = 0; i < 300; i++) {
+        sprintf(json + strlen(json), "%s\"%d\"", i > 0 ? "," : "", i);
+    }
+
+    strcat(json, "]}");
+    TEST_ESP_OK(decode(json, &model));
+
+    TEST_ASSERT_EQUAL(300, model->tags_len);
+
+    for(int i = 0; i < 300; i++) {
+        char expected[8];
+        sprintf(expected, "%d", i);
+        TEST_ASSERT_EQUAL_STRING(expected, model->tags[i]);
+    }
+
+    dcjs_schema_free(&test_model_schema, model);
+}
+
+TEST_CASE("schema decoder fails when array length overflows its field", "[json_schema]")
+{
+    char json[2048] = "{\"ids\": [";
+    test_model_t* model = NULL;
+
+    for(int i = 0; i < UINT8_MAX + 1; i++) {
+        sprintf(json + strlen(json), "%s\"%d\"", i > 0 ? "," : "", i + 1);
+    }
+
+    strcat(json, "]}");
+    TEST_ESP_ERR(ESP_ERR_INVALID_SIZE, decode(json, &model));
+}
+
+TEST_CASE("schema decoder returns null for null object", "[json_schema]")
+{
+    test_model_t* model = (test_model_t*) 1;
+
+    TEST_ESP_OK(decode("null", &model));
+    TEST_ASSERT_NULL(model);
+}
+
+TEST_CASE("schema decoder allocates model from arena", "[json_schema][earena]")
+{
+    earena_handle_t arena = earena_create(64);
+    char json[1024] = "{\"name\": \"first\", \"item\": {\"name\": \"first\"}, \"name\": \"second\", \"item\": {\"value\": 2}, \"ids\": [";
+    test_model_t* model = NULL;
+
+    TEST_ASSERT_NOT_NULL(arena);
+
+    for(int i = 0; i < 100; i++) {
+        sprintf(json + strlen(json), "%s\"%d\"", i > 0 ? "," : "", i + 1);
+    }
+
+    strcat(json, "], \"tags\": [\"a\", \"b\", \"c\"], \"items\": [{\"value\": 1}, {\"value\": 2}, {\"value\": 3}]}");
+    TEST_ESP_OK(decode_(json, arena, &model));
+
+    TEST_ASSERT_EQUAL_STRING("second", model->name);
+    TEST_ASSERT_NULL(model->item->name);
+    TEST_ASSERT_EQUAL(2, model->item->value);
+
+    // array growth interleaved with the allocations of the other fields
+    TEST_ASSERT_EQUAL(100, model->ids_len);
+
+    for(int i = 0; i < 100; i++) {
+        TEST_ASSERT_EQUAL_UINT64(i + 1, model->ids[i]);
+    }
+
+    TEST_ASSERT_EQUAL(3, model->tags_len);
+    TEST_ASSERT_EQUAL_STRING("c", model->tags[2]);
+    TEST_ASSERT_EQUAL(3, model->items_len);
+    TEST_ASSERT_EQUAL(3, model->items[2]->value);
+
+    earena_destroy(arena); // releases the model
+}
+
+TEST_CASE("schema decoder abandons partially decoded model in arena", "[json_schema][earena]")
+{
+    earena_handle_t arena = earena_create(64);
+    test_model_t* model = NULL;
+
+    TEST_ASSERT_NOT_NULL(arena);
+    TEST_ASSERT_NOT_EQUAL(ESP_OK, decode_("{\"name\": \"model\", \"tags\": [\"a\", }", arena, &model));
+    TEST_ASSERT_NULL(model);
+
+    earena_destroy(arena);
+}
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include "unity.h"
+#include "discord/private/_json_stream.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_LOG_SIZE 512
+
+typedef struct {
+    char data[TEST_LOG_SIZE];
+    size_t len;
+} test_log_t;
+
+/**
+ * @brief Record every event as a short text, so the events of two parses can be compared
+ */
+static esp_err_t log_handler(const dcjs_event_t* event, void* arg) {
+    test_log_t* log = (test_log_t*) arg;
+    const char* type = "";
+
+    switch(event->type) {
+        case DCJS_EVENT_OBJECT_START: type = "{"; break;
+        case DCJS_EVENT_OBJECT_END:   type = "}"; break;
+        case DCJS_EVENT_ARRAY_START:  type = "["; break;
+        case DCJS_EVENT_ARRAY_END:    type = "]"; break;
+        case DCJS_EVENT_STRING:       type = "s"; break;
+        case DCJS_EVENT_NUMBER:       type = "n"; break;
+        case DCJS_EVENT_TRUE:         type = "T"; break;
+        case DCJS_EVENT_FALSE:        type = "F"; break;
+        case DCJS_EVENT_NULL:         type = "N"; break;
+    }
+
+    log->len += snprintf(log->data + log->len, TEST_LOG_SIZE - log->len, "%d:%s%s%s%s ",
+        event->depth,
+        event->key ? event->key : "",
+        event->key ? "=" : "",
+        type,
+        event->value ? event->value : ""
+    );
+
+    return log->len < TEST_LOG_SIZE ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static esp_err_t parse(const char* json, size_t chunk_size, test_log_t* log) {
+    dcjs_parser_handle_t parser = dcjs_create(64, log_handler, log);
+    size_t len = strlen(json);
+    esp_err_t err = ESP_OK;
+
+    TEST_ASSERT_NOT_NULL(parser);
+    memset(log, 0, sizeof(test_log_t));
+
+    for(size_t i = 0; i < len && err == ESP_OK; i += chunk_size) {
+        err = dcjs_feed(parser, json + i, len - i < chunk_size ? len - i : chunk_size);
+    }
+
+    if(err == ESP_OK) {
+        err = dcjs_finish(parser);
+    }
+
+    dcjs_destroy(parser);
+
+    return err;
+}
+
+/**
+ * @brief Parse the document split at every position into two chunks and compare the events with the unsplit parse
+ */
+static void assert_split_parse(const char* json, const char* expected) {
+    dcjs_parser_handle_t parser = NULL;
+    test_log_t log, split_log;
+    size_t len = strlen(json);
+
+    TEST_ESP_OK(parse(json, len, &log));
+    TEST_ASSERT_EQUAL_STRING(expected, log.data);
+
+    TEST_ESP_OK(parse(json, 1, &split_log));
+    TEST_ASSERT_EQUAL_STRING(expected, split_log.data);
+
+    for(size_t i = 1; i < len; i++) {
+        TEST_ASSERT_NOT_NULL(parser = dcjs_create(64, log_handler, &split_log));
+        memset(&split_log, 0, sizeof(split_log));
+
+        TEST_ESP_OK(dcjs_feed(parser, json, i));
+        TEST_ESP_OK(dcjs_feed(parser, json + i, len - i));
+        TEST_ESP_OK(dcjs_finish(parser));
+        TEST_ASSERT_EQUAL_STRING(expected, split_log.data);
+
+        dcjs_destroy(parser);
+    }
+}
+
+TEST_CASE("json stream parses document split at any position", "[json_stream]")
+{
+    assert_split_parse(
+        "{\"op\": 0, \"d\": {\"id\": \"81384788765712384\", \"content\": \"a\\\"b\\\\c\\n\", \"n\": [1, -2.5e3, true, false, null], \"e\": {}}, \"s\": 42}",
+        "0:{ 1:op=n0 1:d={ 2:id=s81384788765712384 2:content=sa\"b\\c\n 2:n=[ 3:n1 3:n-2.5e3 3:T 3:F 3:N 2:] 2:e={ 2:} 1:} 1:s=n42 0:} "
+    );
+}
+
+TEST_CASE("json stream parses root scalar values", "[json_stream]")
+{
+    test_log_t log;
+
+    TEST_ESP_OK(parse("1234", 1, &log));
+    TEST_ASSERT_EQUAL_STRING("0:n1234 ", log.data);
+
+    TEST_ESP_OK(parse(" \"text\" ", 3, &log));
+    TEST_ASSERT_EQUAL_STRING("0:stext ", log.data);
+
+    TEST_ESP_OK(parse("null", 2, &log));
+    TEST_ASSERT_EQUAL_STRING("0:N ", log.data);
+}
+
+TEST_CASE("json stream decodes unicode escapes and surrogate pairs", "[json_stream]")
+{
+    // U+00E9, U+20AC and U+1F600 (surrogate pair) split at every position, even inside of the escape sequences
+    assert_split_parse("\"\\u00e9\\u20AC\\ud83d\\ude00!\"", "0:s\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80! ");
+
+    // lone high surrogate is kept as it is
+    assert_split_parse("\"\\ud83dx\"", "0:s\xED\xA0\xBDx ");
+    assert_split_parse("\"\\ud83d\\n\"", "0:s\xED\xA0\xBD\n ");
+}
+
+TEST_CASE("json stream limits nesting depth", "[json_stream]")
+{
+    char json[2 * (DCJS_MAX_DEPTH + 1) + 1];
+    test_log_t log;
+
+    memset(json, '[', DCJS_MAX_DEPTH);
+    memset(json + DCJS_MAX_DEPTH, ']', DCJS_MAX_DEPTH);
+    json[2 * DCJS_MAX_DEPTH] = '\0';
+    TEST_ESP_OK(parse(json, 5, &log));
+
+    memset(json, '[', DCJS_MAX_DEPTH + 1);
+    memset(json + DCJS_MAX_DEPTH + 1, ']', DCJS_MAX_DEPTH + 1);
+    json[2 * (DCJS_MAX_DEPTH + 1)] = '\0';
+    TEST_ESP_ERR(ESP_ERR_INVALID_SIZE, parse(json, 5, &log));
+}
+
+TEST_CASE("json stream limits token length", "[json_stream]")
+{
+    char json[64 + 4];
+    test_log_t log;
+
+    json[0] = '"';
+    memset(json + 1, 'x', 64);
+    json[65] = '"';
+    json[66] = '\0';
+    TEST_ESP_OK(parse(json, 7, &log));
+
+    json[65] = 'x';
+    json[66] = '"';
+    json[67] = '\0';
+    TEST_ESP_ERR(ESP_ERR_INVALID_SIZE, parse(json, 7, &log));
+}
+
+TEST_CASE("json stream rejects syntax errors", "[json_stream]")
+{
+    const char* invalid[] = {
+        "{\"a\" 1}",
+        "{\"a\":1,}",
+        "[1,]",
+        "[1 2]",
+        "{\"a\":tru}",
+        "{\"a\":nul}",
+        "\"\\x\"",
+        "\"\\u12g4\"",
+        "{a:1}",
+        "{}}",
+        "[}",
+        "{\"a\":1]",
+        "+1",
+        "{\"a\":1",
+        "\"open",
+        ""
+    };
+    test_log_t log;
+
+    for(int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        TEST_ASSERT_NOT_EQUAL(ESP_OK, parse(invalid[i], 1, &log));
+        TEST_ASSERT_NOT_EQUAL(ESP_OK, parse(invalid[i], strlen(invalid[i]) + 1, &log));
+    }
+}
+
+TEST_CASE("json stream error is kept until reset", "[json_stream]")
+{
+    test_log_t log = { 0 };
+    dcjs_parser_handle_t parser = dcjs_create(64, log_handler, &log);
+    TEST_ASSERT_NOT_NULL(parser);
+
+    TEST_ESP_ERR(ESP_FAIL, dcjs_feed(parser, "[1,]", 4));
+    TEST_ESP_ERR(ESP_FAIL, dcjs_feed(parser, "[1]", 3));
+    TEST_ESP_ERR(ESP_FAIL, dcjs_finish(parser));
+
+    dcjs_reset(parser);
+    memset(&log, 0, sizeof(log));
+    TEST_ESP_OK(dcjs_feed(parser, "[1]", 3));
+    TEST_ESP_OK(dcjs_finish(parser));
+    TEST_ASSERT_EQUAL_STRING("0:[ 1:n1 0:] ", log.data);
+
+    dcjs_destroy(parser);
+}
\ No newline at end of file
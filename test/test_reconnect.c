@@ -0,0 +1,73 @@
+#include "unity.h"
+#include "discord.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_gateway.h"
+
+#define TEST_SAMPLES 200
+
+TEST_CASE("close codes which cannot be fixed by reconnection stop the client", "[reconnect]")
+{
+    const discord_close_code_t codes[] = {
+        DISCORD_CLOSEOP_AUTHENTICATION_FAILED,
+        DISCORD_CLOSEOP_INVALID_SHARD,
+        DISCORD_CLOSEOP_SHARDING_REQUIRED,
+        DISCORD_CLOSEOP_INVALID_API_VERSION,
+        DISCORD_CLOSEOP_INVALID_INTENTS,
+        DISCORD_CLOSEOP_DISALLOWED_INTENTS
+    };
+
+    for(int i = 0; i < sizeof(codes) / sizeof(codes[0]); i++) {
+        TEST_ASSERT_EQUAL(DISCORD_RECONNECT_NEVER, dcgw_reconnect_rule(codes[i]));
+    }
+}
+
+TEST_CASE("close codes are classified into reconnect rules", "[reconnect]")
+{
+    TEST_ASSERT_EQUAL(DISCORD_RECONNECT_NEW_SESSION, dcgw_reconnect_rule(DISCORD_CLOSEOP_INVALID_SEQ));
+    TEST_ASSERT_EQUAL(DISCORD_RECONNECT_NEW_SESSION, dcgw_reconnect_rule(DISCORD_CLOSEOP_SESSION_TIMED_OUT));
+    TEST_ASSERT_EQUAL(DISCORD_RECONNECT_BACKOFF, dcgw_reconnect_rule(DISCORD_CLOSEOP_RATE_LIMITED));
+
+    // transient errors and unknown codes resume the session
+    TEST_ASSERT_EQUAL(DISCORD_RECONNECT_RESUME, dcgw_reconnect_rule(DISCORD_CLOSEOP_NO_CODE));
+    TEST_ASSERT_EQUAL(DISCORD_RECONNECT_RESUME, dcgw_reconnect_rule(DISCORD_CLOSEOP_UNKNOWN_ERROR));
+    TEST_ASSERT_EQUAL(DISCORD_RECONNECT_RESUME, dcgw_reconnect_rule(DISCORD_CLOSEOP_UNKNOWN_OPCODE));
+    TEST_ASSERT_EQUAL(DISCORD_RECONNECT_RESUME, dcgw_reconnect_rule(DISCORD_CLOSEOP_DECODE_ERROR));
+    TEST_ASSERT_EQUAL(DISCORD_RECONNECT_RESUME, dcgw_reconnect_rule(DISCORD_CLOSEOP_NOT_AUTHENTICATED));
+    TEST_ASSERT_EQUAL(DISCORD_RECONNECT_RESUME, dcgw_reconnect_rule(DISCORD_CLOSEOP_ALREADY_AUTHENTICATED));
+    TEST_ASSERT_EQUAL(DISCORD_RECONNECT_RESUME, dcgw_reconnect_rule((discord_close_code_t) 1006));
+}
+
+TEST_CASE("reconnect delay grows exponentially up to the maximum", "[reconnect]")
+{
+    struct discord client = { 0 };
+    discord_config_t config = { .reconnect_base_ms = 1000, .reconnect_max_ms = 60000 };
+    client.config = &config;
+
+    for(uint8_t attempt = 0; attempt < 40; attempt++) {
+        uint32_t cap = attempt < 6 ? 1000 << attempt : 60000; // 1000 * 2^6 > 60000
+        uint32_t max = 0;
+
+        for(int i = 0; i < TEST_SAMPLES; i++) {
+            uint32_t delay = dcgw_reconnect_delay(&client, attempt);
+            TEST_ASSERT_LESS_OR_EQUAL(cap, delay);
+
+            if(delay > max) {
+                max = delay;
+            }
+        }
+
+        // full jitter, delays are spread over the whole range
+        TEST_ASSERT_GREATER_THAN(cap / 2, max);
+    }
+}
+
+TEST_CASE("reconnect delay is zero without base delay", "[reconnect]")
+{
+    struct discord client = { 0 };
+    discord_config_t config = { .reconnect_base_ms = 0, .reconnect_max_ms = 60000 };
+    client.config = &config;
+
+    for(uint8_t attempt = 0; attempt < 20; attempt++) {
+        TEST_ASSERT_EQUAL(0, dcgw_reconnect_delay(&client, attempt));
+    }
+}
\ No newline at end of file
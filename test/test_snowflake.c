@@ -0,0 +1,52 @@
+#include "unity.h"
+#include "discord/snowflake.h"
+#include <string.h>
+
+TEST_CASE("snowflake is parsed from decimal string", "[snowflake]")
+{
+    TEST_ASSERT_EQUAL_UINT64(175928847299117063ULL, discord_snowflake_from_str("175928847299117063"));
+    TEST_ASSERT_EQUAL_UINT64(1, discord_snowflake_from_str("1"));
+    TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, discord_snowflake_from_str("18446744073709551615"));
+
+    // only first n characters
+    TEST_ASSERT_EQUAL_UINT64(1759, discord_snowflake_from_strn("175928847299117063", 4));
+    TEST_ASSERT_EQUAL_UINT64(42, discord_snowflake_from_strn("42\"}", 2));
+}
+
+TEST_CASE("invalid snowflake is parsed as null", "[snowflake]")
+{
+    TEST_ASSERT_EQUAL_UINT64(DISCORD_SNOWFLAKE_NULL, discord_snowflake_from_str(NULL));
+    TEST_ASSERT_EQUAL_UINT64(DISCORD_SNOWFLAKE_NULL, discord_snowflake_from_str(""));
+    TEST_ASSERT_EQUAL_UINT64(DISCORD_SNOWFLAKE_NULL, discord_snowflake_from_str("-1"));
+    TEST_ASSERT_EQUAL_UINT64(DISCORD_SNOWFLAKE_NULL, discord_snowflake_from_str("12a4"));
+    TEST_ASSERT_EQUAL_UINT64(DISCORD_SNOWFLAKE_NULL, discord_snowflake_from_str(" 1234"));
+    TEST_ASSERT_EQUAL_UINT64(DISCORD_SNOWFLAKE_NULL, discord_snowflake_from_strn("1234", 0));
+}
+
+TEST_CASE("snowflake overflow is parsed as null", "[snowflake]")
+{
+    TEST_ASSERT_EQUAL_UINT64(DISCORD_SNOWFLAKE_NULL, discord_snowflake_from_str("18446744073709551616"));
+    TEST_ASSERT_EQUAL_UINT64(DISCORD_SNOWFLAKE_NULL, discord_snowflake_from_str("99999999999999999999"));
+    TEST_ASSERT_EQUAL_UINT64(DISCORD_SNOWFLAKE_NULL, discord_snowflake_from_str("184467440737095516150"));
+    TEST_ASSERT_EQUAL_UINT64(DISCORD_SNOWFLAKE_NULL, discord_snowflake_from_str("000000000000000000001"));
+}
+
+TEST_CASE("snowflake is formatted as decimal string", "[snowflake]")
+{
+    char buffer[DISCORD_SNOWFLAKE_STR_SIZE];
+
+    TEST_ASSERT_EQUAL_STRING("0", discord_snowflake_to_str(0, buffer));
+    TEST_ASSERT_EQUAL_STRING("175928847299117063", discord_snowflake_to_str(175928847299117063ULL, buffer));
+    TEST_ASSERT_EQUAL_STRING("18446744073709551615", discord_snowflake_to_str(UINT64_MAX, buffer));
+    TEST_ASSERT_EQUAL_STRING("81384788765712384", DISCORD_SNOWFLAKE_STR(81384788765712384ULL));
+
+    // round trip
+    TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, discord_snowflake_from_str(discord_snowflake_to_str(UINT64_MAX, buffer)));
+}
+
+TEST_CASE("snowflake selects shard of the guild", "[snowflake]")
+{
+    // (guild_id >> 22) % shard_count
+    TEST_ASSERT_EQUAL(0, DISCORD_SNOWFLAKE_SHARD(81384788765712384ULL, 1));
+    TEST_ASSERT_EQUAL((81384788765712384ULL >> 22) % 16, DISCORD_SNOWFLAKE_SHARD(81384788765712384ULL, 16));
+}
\ No newline at end of file